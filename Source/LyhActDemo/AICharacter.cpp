@@ -1,18 +1,15 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "AICharacter.h"
-#include "HeadMountedDisplayFunctionLibrary.h"
-#include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
-#include "Components/InputComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
-#include "GameFramework/Controller.h"
-#include "GameFramework/SpringArmComponent.h"
 #include "Engine/Engine.h"
 #include "Components/SkeletalMeshComponent.h"
-#include "TimerManager.h"
-#include "Kismet/KismetMathLibrary.h"
-#include "ConstructorHelpers.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "CombatManager.h"
+#include "MonsterAIController.h"
+#include "LyhActDemoCharacter.h"
 
 
 AAICharacter::AAICharacter()
@@ -31,243 +28,122 @@ AAICharacter::AAICharacter()
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
-	static ConstructorHelpers::FObjectFinder<UDataTable> AIDataObject(TEXT("/Game/Common/stats"));
-	if (AIDataObject.Object)
-	{
-		AIStats = *AIDataObject.Object->FindRow<FPlayerStats>(TEXT("AI"), TEXT(""));
-	}
+	StatsRow = TEXT("AI");
+	AIControllerClass = AMonsterAIController::StaticClass();
+
+	// Far away monsters update their animation less often, off screen ones skip evaluating bones.
+	// The combat manager's animation budget raises this for monsters fighting near a player
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+	GetMesh()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPose;
 }
 
-void AAICharacter::AttackEnemy()
+AAICharacter* AAICharacter::SpawnPooledMonster(UObject* WorldContextObject, TSubclassOf<AAICharacter> Class, const FTransform& Transform)
 {
-	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked)
-	{
-		return;
-	}
-	bIsAttacking = true;
-	//GEngine->AddOnScreenDebugMessage(-1, 5, FColor::Red, TEXT("LeftButton"));
-	bCanDamage = 0;
+	ACombatManager* Manager = ACombatManager::Get(WorldContextObject);
+	return Manager ? Manager->GetMonsterPool().Acquire(Manager->GetWorld(), Class, Transform) : nullptr;
+}
 
-	switch (ComboNum)
+void AAICharacter::PrewarmMonsterPool(UObject* WorldContextObject, TSubclassOf<AAICharacter> Class, int32 Count)
+{
+	if (ACombatManager* Manager = ACombatManager::Get(WorldContextObject))
 	{
-	case 0:
-		if (Fast_One)
-		{
-			float Deruction = PlayAnimMontage(Fast_One);
-			ComboNum++;
-			GetWorldTimerManager().SetTimer(ComboHandle, this, &AAICharacter::OnAttackComplete, Deruction);
-		}
-		break;
-	case 1:
-		if (Fast_Two)
-		{
-			GetWorldTimerManager().ClearTimer(ComboHandle);
-			float Deruction = PlayAnimMontage(Fast_Two);
-			ComboNum++;
-			GetWorldTimerManager().SetTimer(ComboHandle, this, &AAICharacter::OnAttackComplete, Deruction);
-		}
-		break;
-	case 2:
-		if (Fast_Three)
-		{
-			GetWorldTimerManager().ClearTimer(ComboHandle);
-			PlayAnimMontage(Fast_Three);
-			ComboNum = 0;
-		}
-		break;
+		Manager->GetMonsterPool().Prewarm(Manager->GetWorld(), Class, Count);
 	}
-
 }
 
-void AAICharacter::Dodge()
+void AAICharacter::ReturnToPool()
 {
-	if (bIsDefencing || GetMovementComponent()->IsFalling() || bIsDodging)
-	{
-		return;
-	}
-	GetMesh()->Stop();
-	if (bIsAttacking)
+	if (ACombatManager* Manager = ACombatManager::Get(this))
 	{
-		OnAttackComplete();
-		bIsAttacking = false;
-		bCanDamage = 0;
+		Manager->GetMonsterPool().Release(this);
 	}
-	bIsAttacked = false;
-	GetWorldTimerManager().ClearTimer(HurtHandle);
-	bIsDodging = true;
-	float Duration = 0;
-	if (RightVextor > LeftVector)
+	else
 	{
-		if (Dodge_Right)
-		{
-			Duration = PlayAnimMontage(Dodge_Right);
-		}
+		Destroy();
 	}
-	else if (RightVextor < LeftVector)
+}
+
+void AAICharacter::DeathToReborn_Implementation()
+{
+	bIsDeath = true;
+	ReturnToPool();
+}
+
+bool AAICharacter::CanStartAttack()
+{
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!Manager || Role != ROLE_Authority)
 	{
-		Duration = PlayAnimMontage(Dodge_Left);
+		return true;
 	}
-	else
+	FCombatTargetQuery Query;
+	Query.Origin = GetActorLocation();
+	Query.Radius = Manager->AttackTokenRange;
+	Query.TargetClass = ALyhActDemoCharacter::StaticClass();
+	Query.IgnoreActor = this;
+	TArray<FCombatTarget> Targets;
+	if (Manager->GetTargetGrid().Query(Query, Targets) == 0)
 	{
-		Duration = PlayAnimMontage(Dodge_Behind);
+		// Swinging at nothing costs nobody a token
+		return true;
 	}
-	GetWorldTimerManager().SetTimer(DodgeHandle, this, &AAICharacter::OnDodgeComplete, Duration);
+	// Closer monsters are granted first; a refused monster asks again the next time its tree tries to attack
+	const float Priority = AttackPriority / (1.f + FMath::Sqrt(Targets[0].DistSquared));
+	return Manager->GetAttackTokens().Request(this, Targets[0].Character, Priority);
 }
 
-void AAICharacter::OnAttacked(FVector AttackPoint)
+void AAICharacter::Deactivate()
 {
-	if (bIsDodging)
+	bPooled = true;
+	if (ACombatManager* Manager = ACombatManager::Get(this))
 	{
-		return;
+		Manager->UnregisterCombatant(this);
 	}
-	if (bIsDefencing)
+	if (AMonsterAIController* MonsterController = Cast<AMonsterAIController>(GetController()))
 	{
-		if (Defence_Succeed)
-		{
-			PlayAnimMontage(Defence_Succeed);
-		}
-		Defence_End();
+		MonsterController->ReleaseSurroundSlot();
 	}
-	else
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
 	{
-		if (bIsAttacking)
-		{
-			bIsAttacking = false;
-			bCanDamage = false;
-		}
-		bIsAttacked = true;
-		GetWorldTimerManager().SetTimer(HurtHandle, this, &AAICharacter::OnHurtComplete, 1.5f);
-		GetMesh()->Stop();
-		FTransform CharacterTrans = GetActorTransform();
-		FVector CharacterLocation = CharacterTrans.GetLocation();
-		FVector Direction = UKismetMathLibrary::InverseTransformLocation(CharacterTrans, AttackPoint);;
-		if (AttackPoint.Z > CharacterLocation.Z + 53)
+		AIController->StopMovement();
+		if (AIController->BrainComponent)
 		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 0)
-				{
-					if (Hit_HeadTop_Left) PlayAnimMontage(Hit_HeadTop_Left);
-				}
-				else
-				{
-					if (Hit_HeadTop_Right) PlayAnimMontage(Hit_HeadTop_Right);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			AIStats.Blood -= 10 * 2;
-		}
-		else if (AttackPoint.Z > CharacterLocation.Z + 36)
-		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 0)
-				{
-					if (Hit_HeadDown_Left) PlayAnimMontage(Hit_HeadDown_Left);
-				}
-				else
-				{
-					if (Hit_HeadDown_Right) PlayAnimMontage(Hit_HeadDown_Right);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			AIStats.Blood -= 10 * 2;
-		}
-		else if (AttackPoint.Z > CharacterLocation.Z)
-		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 10)
-				{
-					if (Hit_Torso_Left) PlayAnimMontage(Hit_Torso_Left);
-				}
-				else if (Direction.X < -10)
-				{
-					if (Hit_Torso_Right) PlayAnimMontage(Hit_Torso_Right);
-				}
-				else
-				{
-					if (Hit_Torso_Front) PlayAnimMontage(Hit_Torso_Front);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			AIStats.Blood -= 10;
-		}
-		else
-		{
-			if (Direction.X > 0)
-			{
-				if (Hit_Leg_Left) PlayAnimMontage(Hit_Leg_Left);
-			}
-			else
-			{
-				if (Hit_Leg_Right) PlayAnimMontage(Hit_Leg_Right);
-			}
-			AIStats.Blood -= 10;
-		}
-		if (AIStats.Blood <= 0)
-		{
-			DeathToReborn();
+			AIController->BrainComponent->StopLogic(TEXT("Pooled"));
 		}
 	}
+	GetMesh()->Stop();
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	SetActorTickEnabled(false);
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+	// Clients hide it with the last update, after that the net driver can forget about it
+	SetNetDormancy(DORM_DormantAll);
 }
 
-void AAICharacter::OnAttackComplete()
-{
-	GetWorldTimerManager().ClearTimer(ComboHandle);
-	ComboNum = 0;
-}
-
-void AAICharacter::OnDodgeComplete()
-{
-	bIsDodging = false;
-	GetWorldTimerManager().ClearTimer(DodgeHandle);
-}
-
-void AAICharacter::OnHurtComplete()
-{
-	bIsAttacked = false;
-	GetWorldTimerManager().ClearTimer(HurtHandle);
-}
-
-void AAICharacter::Defence_Begin()
+void AAICharacter::Reactivate(const FTransform& Transform)
 {
-	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked)
+	bPooled = false;
+	SetNetDormancy(DORM_Awake);
+	SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	ResetCombatState();
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+	if (ACombatManager* Manager = ACombatManager::Get(this))
 	{
-		return;
+		Manager->RegisterCombatant(this);
 	}
-	bIsDefencing = true;
-	if (Defence_Start)
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
 	{
-		PlayAnimMontage(Defence_Start);
-	}
-	GetCharacterMovement()->MaxWalkSpeed = 200;
-}
-
-void AAICharacter::Defence_End()
-{
-	bIsDefencing = false;
-	GetCharacterMovement()->MaxWalkSpeed = 600;
-}
-
-void AAICharacter::OnBounced()
-{
-	GetMesh()->Stop();
-	bIsAttacking = false;
-	if (Hit_Torso_Front)
-	{
-		PlayAnimMontage(Hit_Torso_Front);
+		if (AIController->BrainComponent)
+		{
+			AIController->BrainComponent->RestartLogic();
+		}
 	}
-	OnAttackComplete();
 }
-
-
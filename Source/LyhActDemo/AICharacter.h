@@ -3,94 +3,49 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Character.h"
-#include "Kismet/KismetSystemLibrary.h"
+#include "CombatCharacter.h"
 #include "PlayerStats.h"
 #include "AICharacter.generated.h"
 
 UCLASS(config = Game)
-class AAICharacter : public ACharacter
+class AAICharacter : public ACombatCharacter
 {
 	GENERATED_BODY()
 public:
 	AAICharacter();
 public:
-	int32 ComboNum = 0;
-	int8 LeftVector = 0;
-	int8 RightVextor = 0;
 	UPROPERTY(BlueprintReadWrite)
 	FPlayerStats AIStats;
 
-	/***********************state********************/
-	bool bIsDodging = false;
-	bool bIsDefencing = false;
-	bool bIsDeath = false;
-	bool bIsAttacked = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bIsAttacking = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bCanDamage = 0;
-	/***********************state********************/
+	/** Scales the claim of this monster on attack tokens against closer ones, e.g. for elites */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Combat")
+	float AttackPriority = 1.f;
 
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Fast_One;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Fast_Two;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Fast_Three;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Back;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_HeadTop_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_HeadTop_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_HeadDown_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_HeadDown_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Torso_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Torso_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Torso_Front;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Leg_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Hit_Leg_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Dodge_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Dodge_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Dodge_Behind;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Defence_Start;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-		UAnimMontage* Defence_Succeed;
+	virtual FPlayerStats& GetCombatStats() override { return AIStats; }
 
-	FTimerHandle ComboHandle;
-	FTimerHandle DodgeHandle;
-	FTimerHandle HurtHandle;
-public:
-	UFUNCTION(BlueprintCallable)
-	void AttackEnemy();
-	void Dodge();
-	UFUNCTION(BlueprintCallable)
-	void OnAttacked(FVector AttackPoint);
-	UFUNCTION()
-	void OnAttackComplete();
-	UFUNCTION()
-	void OnDodgeComplete();
-	UFUNCTION()
-	void OnHurtComplete();
-	UFUNCTION()
-	void Defence_Begin();
-	UFUNCTION()
-	void Defence_End();
-	UFUNCTION(BlueprintCallable)
-	void OnBounced();
-	UFUNCTION(BlueprintImplementableEvent)
-	void DeathToReborn();
-};
+	/** Spawns a monster of Class at Transform, reusing a dead one from the pool when possible */
+	UFUNCTION(BlueprintCallable, Category = "Pool", meta = (WorldContext = "WorldContextObject"))
+	static AAICharacter* SpawnPooledMonster(UObject* WorldContextObject, TSubclassOf<AAICharacter> Class, const FTransform& Transform);
+
+	/** Spawns Count parked monsters of Class, call before a wave */
+	UFUNCTION(BlueprintCallable, Category = "Pool", meta = (WorldContext = "WorldContextObject"))
+	static void PrewarmMonsterPool(UObject* WorldContextObject, TSubclassOf<AAICharacter> Class, int32 Count);
 
+	/** Hides the monster and parks it in the pool instead of destroying it */
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void ReturnToPool();
+
+	/** Turns off rendering, collision, movement, ticking and the behavior tree */
+	void Deactivate();
+	/** Undoes Deactivate at Transform with fresh stats */
+	void Reactivate(const FTransform& Transform);
+	bool IsPooled() const { return bPooled; }
+
+	/** Dead monsters go back to the pool unless the Blueprint overrides this */
+	virtual void DeathToReborn_Implementation() override;
+protected:
+	/** Attacks on a player need one of its attack tokens, see FCombatAttackTokens */
+	virtual bool CanStartAttack() override;
+private:
+	bool bPooled = false;
+};
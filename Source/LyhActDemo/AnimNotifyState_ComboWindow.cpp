@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AnimNotifyState_ComboWindow.h"
+#include "CombatCharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void UAnimNotifyState_ComboWindow::NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration)
+{
+	Super::NotifyBegin(MeshComp, Animation, TotalDuration);
+	if (ACombatCharacter* Character = Cast<ACombatCharacter>(MeshComp->GetOwner()))
+	{
+		Character->OpenCancelWindow();
+	}
+}
+
+void UAnimNotifyState_ComboWindow::NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation)
+{
+	if (ACombatCharacter* Character = Cast<ACombatCharacter>(MeshComp->GetOwner()))
+	{
+		Character->CloseCancelWindow();
+	}
+	Super::NotifyEnd(MeshComp, Animation);
+}
+
+FString UAnimNotifyState_ComboWindow::GetNotifyName_Implementation() const
+{
+	return TEXT("Combo Window");
+}
@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotifyState.h"
+#include "AnimNotifyState_ComboWindow.generated.h"
+
+/**
+ * Part of an attack montage the next swing or a dodge may cut in. Buffered presses are played the
+ * frame the window opens, later presses as soon as they arrive.
+ */
+UCLASS(meta = (DisplayName = "Combo Window"))
+class LYHACTDEMO_API UAnimNotifyState_ComboWindow : public UAnimNotifyState
+{
+	GENERATED_BODY()
+public:
+	virtual void NotifyBegin(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, float TotalDuration) override;
+	virtual void NotifyEnd(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation) override;
+	virtual FString GetNotifyName_Implementation() const override;
+};
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatAnimBudget.h"
+#include "AICharacter.h"
+#include "Components/SkeletalMeshComponent.h"
+
+namespace CombatAnimBudget
+{
+	/** Seconds between two rankings */
+	const float UpdateInterval = 0.25f;
+	/** Slowest a mesh is updated, in frames */
+	const int32 MaxFrameInterval = 8;
+}
+
+void FCombatAnimBudget::SetBudget(int32 InUpdatesPerFrame, float InFullRateDistance)
+{
+	UpdatesPerFrame = FMath::Max(InUpdatesPerFrame, 1);
+	FullRateDistance = InFullRateDistance;
+}
+
+void FCombatAnimBudget::Register(AAICharacter* Monster)
+{
+	if (!Monster || Entries.ContainsByPredicate([Monster](const FEntry& Entry) { return Entry.Monster == Monster; }))
+	{
+		return;
+	}
+	FEntry Entry;
+	Entry.Monster = Monster;
+	Entry.DistSquared = 0.f;
+	Entry.FrameInterval = 0;
+	Entry.bCritical = false;
+	Entry.bAppliedCritical = false;
+	Entries.Add(Entry);
+}
+
+void FCombatAnimBudget::Unregister(AAICharacter* Monster)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Monster](const FEntry& Entry) { return Entry.Monster == Monster; });
+	if (Index != INDEX_NONE)
+	{
+		Entries.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+void FCombatAnimBudget::ApplyIfChanged(FEntry& Entry, int32 FrameInterval)
+{
+	if (Entry.FrameInterval == FrameInterval && Entry.bAppliedCritical == Entry.bCritical)
+	{
+		return;
+	}
+	Entry.FrameInterval = FrameInterval;
+	Entry.bAppliedCritical = Entry.bCritical;
+	USkeletalMeshComponent* Mesh = Entry.Monster->GetMesh();
+	// Fighting monsters need their bones even when nobody sees them, the weapon trace reads the blade sockets
+	Mesh->MeshComponentUpdateFlag = Entry.bCritical ? EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones : EMeshComponentUpdateFlag::AlwaysTickPose;
+	// Half a frame early so jitter in the frame time does not stretch the interval by a whole frame
+	Mesh->SetComponentTickInterval(FrameInterval > 1 ? (FrameInterval - 0.5f) * AverageFrameTime : 0.f);
+}
+
+void FCombatAnimBudget::Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations)
+{
+	AverageFrameTime = AverageFrameTime * 0.9f + DeltaSeconds * 0.1f;
+	TimeToUpdate -= DeltaSeconds;
+	if (TimeToUpdate > 0.f)
+	{
+		return;
+	}
+	TimeToUpdate = CombatAnimBudget::UpdateInterval;
+
+	Order.Reset();
+	int32 Remaining = UpdatesPerFrame;
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FEntry& Entry = Entries[Index];
+		const AAICharacter* Monster = Entry.Monster.Get();
+		if (!Monster)
+		{
+			Entries.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+		const FVector Location = Monster->GetActorLocation();
+		Entry.DistSquared = BIG_NUMBER;
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			Entry.DistSquared = FMath::Min(Entry.DistSquared, FVector::DistSquared(Location, PlayerLocation));
+		}
+		const bool bFighting = Monster->bIsAttacking || Monster->bIsAttacked || Monster->bIsDodging || Monster->bIsDefencing;
+		Entry.bCritical = bFighting || Entry.DistSquared <= FMath::Square(FullRateDistance);
+		if (Entry.bCritical)
+		{
+			Remaining--;
+		}
+	}
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		if (Entries[Index].bCritical)
+		{
+			ApplyIfChanged(Entries[Index], 1);
+		}
+		else
+		{
+			Order.Add(Index);
+		}
+	}
+
+	// Everyone else starts at the slowest rate, then the nearest are sped up while the budget lasts
+	Order.Sort([this](int32 A, int32 B) { return Entries[A].DistSquared < Entries[B].DistSquared; });
+	float Spent = Order.Num() / float(CombatAnimBudget::MaxFrameInterval);
+	for (int32 Index : Order)
+	{
+		int32 Interval = CombatAnimBudget::MaxFrameInterval;
+		// Halving the interval adds another 1 / Interval updates per frame
+		while (Interval > 1 && Spent + 1.f / Interval <= Remaining)
+		{
+			Spent += 1.f / Interval;
+			Interval /= 2;
+		}
+		ApplyIfChanged(Entries[Index], Interval);
+	}
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AAICharacter;
+
+/**
+ * Caps how many monster meshes update their animation per frame. Monsters fighting near a player
+ * always update every frame; the rest are ranked by distance to the closest player and the nearest
+ * ones get the most frequent updates the remaining budget allows, down to one update every few frames.
+ * Off screen, meshes keep the montages running for notifies but skip evaluating bones.
+ */
+class LYHACTDEMO_API FCombatAnimBudget
+{
+public:
+	void SetBudget(int32 InUpdatesPerFrame, float InFullRateDistance);
+	void Register(AAICharacter* Monster);
+	void Unregister(AAICharacter* Monster);
+	int32 Num() const { return Entries.Num(); }
+
+	void Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations);
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<AAICharacter> Monster;
+		float DistSquared;
+		/** Frames between two updates of the mesh, 0 until first assigned */
+		uint8 FrameInterval;
+		uint8 bCritical : 1;
+		uint8 bAppliedCritical : 1;
+	};
+
+	void ApplyIfChanged(FEntry& Entry, int32 FrameInterval);
+
+	TArray<FEntry> Entries;
+	TArray<int32> Order;
+	int32 UpdatesPerFrame = 60;
+	float FullRateDistance = 1500.f;
+	float TimeToUpdate = 0.f;
+	float AverageFrameTime = 1.f / 60.f;
+};
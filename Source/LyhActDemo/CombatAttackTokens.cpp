@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatAttackTokens.h"
+#include "CombatCharacter.h"
+
+void FCombatAttackTokens::SetTokens(int32 InTokensPerTarget, float InLeaseTime)
+{
+	TokensPerTarget = FMath::Max(InTokensPerTarget, 1);
+	LeaseTime = InLeaseTime;
+}
+
+bool FCombatAttackTokens::Request(ACombatCharacter* Attacker, ACombatCharacter* Target, float Priority)
+{
+	if (!Attacker || !Target)
+	{
+		return false;
+	}
+	const TWeakObjectPtr<ACombatCharacter> Key(Attacker);
+	// An attacker holds one token at a time, turning to another target gives the old one back
+	const TWeakObjectPtr<ACombatCharacter>* HeldTarget = HeldTargets.Find(Key);
+	if (HeldTarget && *HeldTarget != Target)
+	{
+		Release(Attacker);
+	}
+	FTargetTokens& Tokens = Targets.FindOrAdd(Target);
+	if (FToken* Held = Tokens.Held.FindByPredicate([&Key](const FToken& Token) { return Token.Holder == Key; }))
+	{
+		// The lease covers one combo, the next combo starts a new one
+		if (Attacker->ComboNum == 0)
+		{
+			Held->GrantTime = LastUpdateTime;
+		}
+		return true;
+	}
+	// One request per attacker and frame, asking again only raises the priority
+	if (FRequest* Pending = Tokens.Pending.FindByPredicate([&Key](const FRequest& Request) { return Request.Attacker == Key; }))
+	{
+		Pending->Priority = FMath::Max(Pending->Priority, Priority);
+	}
+	else
+	{
+		FRequest Request;
+		Request.Attacker = Key;
+		Request.Priority = Priority;
+		Tokens.Pending.Add(Request);
+	}
+	return false;
+}
+
+void FCombatAttackTokens::Release(ACombatCharacter* Attacker)
+{
+	const TWeakObjectPtr<ACombatCharacter> Key(Attacker);
+	TWeakObjectPtr<ACombatCharacter> Target;
+	if (!HeldTargets.RemoveAndCopyValue(Key, Target))
+	{
+		return;
+	}
+	if (FTargetTokens* Tokens = Targets.Find(Target))
+	{
+		Tokens->Held.RemoveAllSwap([&Key](const FToken& Token) { return Token.Holder == Key; });
+	}
+}
+
+int32 FCombatAttackTokens::NumHeld(const ACombatCharacter* Target) const
+{
+	const FTargetTokens* Tokens = Targets.Find(const_cast<ACombatCharacter*>(Target));
+	return Tokens ? Tokens->Held.Num() : 0;
+}
+
+void FCombatAttackTokens::Update(float Now)
+{
+	LastUpdateTime = Now;
+	for (auto It = Targets.CreateIterator(); It; ++It)
+	{
+		const ACombatCharacter* Target = It->Key.Get();
+		FTargetTokens& Tokens = It->Value;
+		if (!Target || Target->bIsDeath)
+		{
+			for (const FToken& Token : Tokens.Held)
+			{
+				HeldTargets.Remove(Token.Holder);
+			}
+			It.RemoveCurrent();
+			continue;
+		}
+		Tokens.Held.RemoveAllSwap([Now, this](const FToken& Token)
+		{
+			const ACombatCharacter* Holder = Token.Holder.Get();
+			if (!Holder || Holder->bIsDeath || Now - Token.GrantTime > LeaseTime)
+			{
+				HeldTargets.Remove(Token.Holder);
+				return true;
+			}
+			return false;
+		});
+		if (Tokens.Pending.Num() == 0)
+		{
+			continue;
+		}
+
+		int32 Free = TokensPerTarget - Tokens.Held.Num();
+		if (Free > 0)
+		{
+			Tokens.Pending.Sort([](const FRequest& A, const FRequest& B) { return A.Priority > B.Priority; });
+			for (const FRequest& Request : Tokens.Pending)
+			{
+				if (Free == 0)
+				{
+					break;
+				}
+				// Asked for another target as well this frame and got that one first
+				if (Request.Attacker.IsValid() && !HeldTargets.Contains(Request.Attacker))
+				{
+					FToken Token;
+					Token.Holder = Request.Attacker;
+					Token.GrantTime = Now;
+					Tokens.Held.Add(Token);
+					HeldTargets.Add(Request.Attacker, It->Key);
+					Free--;
+				}
+			}
+		}
+		// Requests are made again every frame the attacker still wants to attack
+		Tokens.Pending.Reset();
+	}
+}
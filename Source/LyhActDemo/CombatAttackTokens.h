@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class ACombatCharacter;
+
+/**
+ * Limits how many attackers may attack one target at a time. An attacker asks for a token before
+ * it starts an attack; the requests of a frame are granted once per frame to the highest priorities
+ * while the target has tokens left. Tokens come back when the attack ends, or after a lease time
+ * if the attacker never returns them. An attacker holds at most one token, asking another target
+ * for one gives the old one back.
+ */
+class LYHACTDEMO_API FCombatAttackTokens
+{
+public:
+	void SetTokens(int32 InTokensPerTarget, float InLeaseTime);
+
+	/** True if Attacker holds a token on Target, otherwise queues the request for the next grant. Asking
+	 *  for the first swing of a combo renews the lease of a held token */
+	bool Request(ACombatCharacter* Attacker, ACombatCharacter* Target, float Priority);
+	/** Gives back the token Attacker holds, if any */
+	void Release(ACombatCharacter* Attacker);
+	int32 NumHeld(const ACombatCharacter* Target) const;
+
+	void Update(float Now);
+private:
+	struct FToken
+	{
+		TWeakObjectPtr<ACombatCharacter> Holder;
+		float GrantTime;
+	};
+
+	struct FRequest
+	{
+		TWeakObjectPtr<ACombatCharacter> Attacker;
+		float Priority;
+	};
+
+	struct FTargetTokens
+	{
+		TArray<FToken> Held;
+		TArray<FRequest> Pending;
+	};
+
+	TMap<TWeakObjectPtr<ACombatCharacter>, FTargetTokens> Targets;
+	/** Target of the one token each holder has */
+	TMap<TWeakObjectPtr<ACombatCharacter>, TWeakObjectPtr<ACombatCharacter>> HeldTargets;
+	int32 TokensPerTarget = 2;
+	float LeaseTime = 5.f;
+	float LastUpdateTime = 0.f;
+};
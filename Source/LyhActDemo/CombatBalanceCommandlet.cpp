@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatBalanceCommandlet.h"
+#include "LyhActDemo.h"
+#include "AICharacter.h"
+#include "LyhActDemoCharacter.h"
+#include "CombatDuelModel.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+namespace CombatBalance
+{
+	/** The Blueprints the game plays with, the native classes have no montages */
+	const TCHAR* DefaultPlayerClass = TEXT("/Game/Common/ThirdPersonCharacter.ThirdPersonCharacter_C");
+	const TCHAR* DefaultMonsterClass = TEXT("/Game/AI/BP_AICharacter.BP_AICharacter_C");
+
+	/** Duels one worker plays in a row, enough to hide the cost of handing out work */
+	const int32 DuelsPerBatch = 256;
+
+	/** Settings that can be given on the command line or swept */
+	const TCHAR* const Settings[] =
+	{
+		TEXT("PlayerBlood"), TEXT("PlayerMagic"), TEXT("PlayerMagicRegain"),
+		TEXT("MonsterBlood"), TEXT("MonsterMagic"), TEXT("MonsterMagicRegain"),
+		TEXT("DodgeCost"), TEXT("DefenceCost"), TEXT("HeadMultiplier"), TEXT("HeadHitChance"),
+		TEXT("PlayerAttackRate"), TEXT("PlayerDodgeChance"), TEXT("PlayerDefenceChance"), TEXT("PlayerReactionTime"),
+		TEXT("MonsterAttackRate"), TEXT("MonsterDodgeChance"), TEXT("MonsterDefenceChance"), TEXT("MonsterReactionTime"),
+	};
+
+	float Percentile(const TArray<float>& Sorted, float Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Sorted.Num() * Fraction), 0, Sorted.Num() - 1)] : 0.f;
+	}
+
+	float Mean(const TArray<float>& Values)
+	{
+		float Total = 0.f;
+		for (float Value : Values)
+		{
+			Total += Value;
+		}
+		return Values.Num() > 0 ? Total / Values.Num() : 0.f;
+	}
+}
+
+UCombatBalanceCommandlet::UCombatBalanceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+bool UCombatBalanceCommandlet::ApplySetting(const FString& Name, float Value, FDuelFighter& Player, FDuelFighter& Monster)
+{
+	const int32 IntValue = FMath::RoundToInt(Value);
+	if (Name == TEXT("PlayerBlood")) { Player.Stats.Blood = IntValue; }
+	else if (Name == TEXT("PlayerMagic")) { Player.Stats.Magic = IntValue; }
+	else if (Name == TEXT("PlayerMagicRegain")) { Player.Stats.MagicRegain = IntValue; }
+	else if (Name == TEXT("MonsterBlood")) { Monster.Stats.Blood = IntValue; }
+	else if (Name == TEXT("MonsterMagic")) { Monster.Stats.Magic = IntValue; }
+	else if (Name == TEXT("MonsterMagicRegain")) { Monster.Stats.MagicRegain = IntValue; }
+	else if (Name == TEXT("DodgeCost")) { Player.DodgeMagicCost = IntValue; }
+	else if (Name == TEXT("DefenceCost")) { Player.DefenceMagicCost = IntValue; }
+	else if (Name == TEXT("HeadMultiplier")) { Player.HeadMultiplier = Value; Monster.HeadMultiplier = Value; }
+	else if (Name == TEXT("HeadHitChance")) { Player.HeadHitChance = Value; Monster.HeadHitChance = Value; }
+	else if (Name == TEXT("PlayerAttackRate")) { Player.Policy.AttackRate = Value; }
+	else if (Name == TEXT("PlayerDodgeChance")) { Player.Policy.DodgeChance = Value; }
+	else if (Name == TEXT("PlayerDefenceChance")) { Player.Policy.DefenceChance = Value; }
+	else if (Name == TEXT("PlayerReactionTime")) { Player.Policy.ReactionTime = Value; }
+	else if (Name == TEXT("MonsterAttackRate")) { Monster.Policy.AttackRate = Value; }
+	else if (Name == TEXT("MonsterDodgeChance")) { Monster.Policy.DodgeChance = Value; }
+	else if (Name == TEXT("MonsterDefenceChance")) { Monster.Policy.DefenceChance = Value; }
+	else if (Name == TEXT("MonsterReactionTime")) { Monster.Policy.ReactionTime = Value; }
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+int32 UCombatBalanceCommandlet::Main(const FString& Params)
+{
+	int32 NumDuels = 10000;
+	int32 Seed = 1;
+	int32 StepRate = 30;
+	float MaxTime = 120.f;
+	FString PlayerClassPath = CombatBalance::DefaultPlayerClass;
+	FString MonsterClassPath = CombatBalance::DefaultMonsterClass;
+	FString Sweep;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Balance/CombatBalance.csv");
+	FParse::Value(*Params, TEXT("Duels="), NumDuels);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("StepRate="), StepRate);
+	FParse::Value(*Params, TEXT("MaxTime="), MaxTime);
+	FParse::Value(*Params, TEXT("PlayerClass="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("MonsterClass="), MonsterClassPath);
+	FParse::Value(*Params, TEXT("Sweep="), Sweep);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	NumDuels = FMath::Max(NumDuels, 1);
+	StepRate = FMath::Max(StepRate, 1);
+
+	UClass* PlayerClass = LoadClass<ALyhActDemoCharacter>(nullptr, *PlayerClassPath);
+	UClass* MonsterClass = LoadClass<AAICharacter>(nullptr, *MonsterClassPath);
+	if (!PlayerClass || !MonsterClass)
+	{
+		UE_LOG(LogLyhCombat, Error, TEXT("CombatBalance: could not load the player class %s or the monster class %s"), *PlayerClassPath, *MonsterClassPath);
+		return 1;
+	}
+
+	// The player plays like a person, the monster like the behavior tree
+	FDuelFighter BasePlayer;
+	BasePlayer.InitFromClass(PlayerClass);
+	BasePlayer.bNoRegenWhileDefending = true;
+	BasePlayer.Policy.AttackRate = 2.f;
+	BasePlayer.Policy.DodgeChance = 0.35f;
+	BasePlayer.Policy.DefenceChance = 0.3f;
+	FDuelFighter BaseMonster;
+	BaseMonster.InitFromClass(MonsterClass);
+	BaseMonster.Policy.AttackRate = 1.f;
+	BaseMonster.Policy.DefenceChance = 0.15f;
+	for (const TCHAR* Setting : CombatBalance::Settings)
+	{
+		float Value = 0.f;
+		if (FParse::Value(*Params, *FString::Printf(TEXT("%s="), Setting), Value))
+		{
+			ApplySetting(Setting, Value, BasePlayer, BaseMonster);
+		}
+	}
+
+	// -Sweep=Name:From:To:Count, without it a single run with the settings above
+	FString SweepName;
+	TArray<float> SweepValues;
+	if (!Sweep.IsEmpty())
+	{
+		TArray<FString> Parts;
+		Sweep.ParseIntoArray(Parts, TEXT(":"));
+		FDuelFighter Probe;
+		if (Parts.Num() != 4 || !ApplySetting(Parts[0], 0.f, Probe, Probe))
+		{
+			UE_LOG(LogLyhCombat, Error, TEXT("CombatBalance: -Sweep=%s is not Name:From:To:Count of a known setting"), *Sweep);
+			return 1;
+		}
+		SweepName = Parts[0];
+		const float From = FCString::Atof(*Parts[1]);
+		const float To = FCString::Atof(*Parts[2]);
+		const int32 Count = FMath::Max(FCString::Atoi(*Parts[3]), 1);
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			SweepValues.Add(Count > 1 ? FMath::Lerp(From, To, (float)Index / (Count - 1)) : From);
+		}
+	}
+	else
+	{
+		SweepName = TEXT("None");
+		SweepValues.Add(0.f);
+	}
+
+	FString Csv = TEXT("Setting,Value,Duels,PlayerWinRate,MonsterWinRate,TimeoutRate,PlayerTTKAvg,PlayerTTKP50,PlayerTTKP90,MonsterTTKAvg,MonsterTTKP50,MonsterTTKP90,PlayerHits,MonsterHits,PlayerDodges,PlayerBlocks\n");
+	TArray<FDuelResult> Results;
+	Results.SetNum(NumDuels);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	for (float Value : SweepValues)
+	{
+		FDuelFighter Player = BasePlayer;
+		FDuelFighter Monster = BaseMonster;
+		if (SweepName != TEXT("None"))
+		{
+			ApplySetting(SweepName, Value, Player, Monster);
+		}
+
+		// Each duel has its own seed, so the results do not depend on how the work was split
+		const int32 NumBatches = FMath::DivideAndRoundUp(NumDuels, CombatBalance::DuelsPerBatch);
+		ParallelFor(NumBatches, [&](int32 Batch)
+		{
+			const int32 End = FMath::Min((Batch + 1) * CombatBalance::DuelsPerBatch, NumDuels);
+			for (int32 Duel = Batch * CombatBalance::DuelsPerBatch; Duel < End; ++Duel)
+			{
+				Results[Duel] = FCombatDuelModel::Run(Player, Monster, (int32)HashCombine((uint32)Seed, (uint32)Duel), StepRate, MaxTime);
+			}
+		});
+
+		int32 Outcomes[3] = { 0, 0, 0 };
+		int64 Hits[2] = { 0, 0 };
+		int64 PlayerDodges = 0;
+		int64 PlayerBlocks = 0;
+		TArray<float> PlayerTTK;
+		TArray<float> MonsterTTK;
+		for (const FDuelResult& Result : Results)
+		{
+			Outcomes[(int32)Result.Outcome]++;
+			Hits[0] += Result.Hits[0];
+			Hits[1] += Result.Hits[1];
+			PlayerDodges += Result.Dodges[0];
+			PlayerBlocks += Result.Blocks[0];
+			if (Result.Outcome == EDuelOutcome::PlayerWon)
+			{
+				PlayerTTK.Add(Result.Time);
+			}
+			else if (Result.Outcome == EDuelOutcome::MonsterWon)
+			{
+				MonsterTTK.Add(Result.Time);
+			}
+		}
+		PlayerTTK.Sort();
+		MonsterTTK.Sort();
+		const float PlayerWinRate = (float)Outcomes[(int32)EDuelOutcome::PlayerWon] / NumDuels;
+		const float MonsterWinRate = (float)Outcomes[(int32)EDuelOutcome::MonsterWon] / NumDuels;
+		const float TimeoutRate = (float)Outcomes[(int32)EDuelOutcome::Timeout] / NumDuels;
+		Csv += FString::Printf(TEXT("%s,%.3f,%d,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n"), *SweepName, Value, NumDuels,
+			PlayerWinRate, MonsterWinRate, TimeoutRate,
+			CombatBalance::Mean(PlayerTTK), CombatBalance::Percentile(PlayerTTK, 0.5f), CombatBalance::Percentile(PlayerTTK, 0.9f),
+			CombatBalance::Mean(MonsterTTK), CombatBalance::Percentile(MonsterTTK, 0.5f), CombatBalance::Percentile(MonsterTTK, 0.9f),
+			(double)Hits[0] / NumDuels, (double)Hits[1] / NumDuels, (double)PlayerDodges / NumDuels, (double)PlayerBlocks / NumDuels);
+		UE_LOG(LogLyhCombat, Display, TEXT("CombatBalance: %s=%.3f PlayerWins=%.1f%% MonsterWins=%.1f%% Timeouts=%.1f%% PlayerTTK=%.2fs MonsterTTK=%.2fs"),
+			*SweepName, Value, PlayerWinRate * 100.f, MonsterWinRate * 100.f, TimeoutRate * 100.f, CombatBalance::Mean(PlayerTTK), CombatBalance::Mean(MonsterTTK));
+	}
+
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatBalance: %d duels in %.2fs"), NumDuels * SweepValues.Num(), Seconds);
+	if (FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogLyhCombat, Display, TEXT("CombatBalance: results written to %s"), *OutputPath);
+	}
+	return 0;
+}
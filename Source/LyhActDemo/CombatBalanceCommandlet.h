@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatBalanceCommandlet.generated.h"
+
+struct FDuelFighter;
+
+/**
+ * Balance sweep over FCombatDuelModel. Plays a number of player versus monster duels on all cores
+ * for every value of the swept setting and writes win rates and time to kill per value.
+ *
+ *   UE4Editor-Cmd LyhActDemo.uproject -run=CombatBalance -nullrhi -unattended
+ *       [-Duels=10000] [-Seed=1] [-StepRate=30] [-MaxTime=120]
+ *       [-PlayerClass=/Game/Common/ThirdPersonCharacter.ThirdPersonCharacter_C] [-MonsterClass=/Game/AI/BP_AICharacter.BP_AICharacter_C]
+ *       [-DodgeCost=10] [-DefenceCost=5] [-HeadMultiplier=2] [-PlayerBlood=] [-MonsterBlood=] ...
+ *       [-Sweep=DodgeCost:0:20:5] [-Output=Saved/Balance/CombatBalance.csv]
+ *
+ * Any setting below can be given once or swept from one value to another in a number of steps.
+ */
+UCLASS()
+class UCombatBalanceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UCombatBalanceCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+private:
+	/** Sets the setting called Name on the fighters, false when there is no such setting */
+	static bool ApplySetting(const FString& Name, float Value, FDuelFighter& Player, FDuelFighter& Monster);
+};
@@ -0,0 +1,342 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatBenchmarkCommandlet.h"
+#include "LyhActDemo.h"
+#include "AICharacter.h"
+#include "LyhActDemoCharacter.h"
+#include "LyhBTService.h"
+#include "CombatManager.h"
+#include "CombatMontageSet.h"
+#include "CombatProfiling.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/MemoryBase.h"
+
+namespace CombatBenchmark
+{
+	/** Frames after which every character's script starts over */
+	const int32 ScriptPeriod = 90;
+	/** Distance between two characters of the spawn grid */
+	const float Spacing = 200.f;
+	/** Swings only land on someone this close */
+	const float HitRange = 250.f;
+	/** Heights the hits land at relative to the victim, one per hit reaction zone */
+	const float HitHeights[] = { 60.f, 40.f, 0.f, -90.f };
+	/** The Blueprints the game plays with, the native classes have no montages */
+	const TCHAR* DefaultPlayerClass = TEXT("/Game/Common/ThirdPersonCharacter.ThirdPersonCharacter_C");
+	const TCHAR* DefaultMonsterClass = TEXT("/Game/AI/BP_AICharacter.BP_AICharacter_C");
+
+	/** Calls into the allocator so far, 0 where the engine does not count them */
+	uint64 GetMallocCalls()
+	{
+#if !UE_BUILD_SHIPPING
+		return (uint64)FMalloc::TotalMallocCalls + FMalloc::TotalReallocCalls;
+#else
+		return 0;
+#endif
+	}
+
+	double ToMs(uint64 Cycles)
+	{
+		return FPlatformTime::ToSeconds64(Cycles) * 1000.0;
+	}
+
+	double Percentile(const TArray<double>& Sorted, float Fraction)
+	{
+		return Sorted.Num() > 0 ? Sorted[FMath::Clamp(FMath::FloorToInt(Sorted.Num() * Fraction), 0, Sorted.Num() - 1)] : 0.0;
+	}
+}
+
+UCombatBenchmarkCommandlet::UCombatBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+	MontageOverride = nullptr;
+}
+
+ACombatCharacter* UCombatBenchmarkCommandlet::SpawnCombatant(UWorld* World, UClass* Class, const FTransform& Transform, bool bMonster)
+{
+	ACombatCharacter* Character = nullptr;
+	if (bMonster)
+	{
+		Character = AAICharacter::SpawnPooledMonster(World, Class, Transform);
+	}
+	else
+	{
+		FActorSpawnParameters SpawnInfo;
+		SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		Character = World->SpawnActor<ACombatCharacter>(Class, Transform, SpawnInfo);
+	}
+	if (Character)
+	{
+		if (MontageOverride)
+		{
+			Character->Montages = MontageOverride;
+		}
+		// The world has no floor, flying keeps the falling checks of attack, dodge and defence passing
+		Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+	}
+	return Character;
+}
+
+void UCombatBenchmarkCommandlet::DriveCombatant(FBenchCombatant& Combatant, int32 Index, int32 Frame)
+{
+	ACombatCharacter* Character = Combatant.Character;
+	if (!Character || Character->bIsDeath)
+	{
+		return;
+	}
+
+	// Offset by index so the population does not act in lockstep
+	const int32 Phase = (Frame + Index * 7) % CombatBenchmark::ScriptPeriod;
+	switch (Phase)
+	{
+	case 0:
+	case 20:
+	case 40:
+		Character->AttackEnemy();
+		break;
+	case 10:
+	case 30:
+	case 50:
+		if (Character->bIsAttacking)
+		{
+			ACombatManager* Manager = ACombatManager::Get(Character);
+			FCombatTargetQuery Query;
+			Query.Origin = Character->GetActorLocation();
+			Query.Radius = CombatBenchmark::HitRange;
+			Query.IgnoreActor = Character;
+			TArray<FCombatTarget> Targets;
+			if (Manager && Manager->GetTargetGrid().Query(Query, Targets) > 0)
+			{
+				const float Height = CombatBenchmark::HitHeights[(Frame / CombatBenchmark::ScriptPeriod + Index) % ARRAY_COUNT(CombatBenchmark::HitHeights)];
+				Targets[0].Character->OnAttackedBy(Targets[0].Character->GetActorLocation() + FVector(0.f, 0.f, Height), Character);
+			}
+		}
+		break;
+	case 15:
+	case 35:
+	case 55:
+		// Stands in for the end of swing notify of the attack montages
+		Character->bIsAttacking = false;
+		Character->bCanDamage = false;
+		break;
+	case 60:
+		Character->LeftVector = FMath::RandRange(0, 1);
+		Character->RightVextor = FMath::RandRange(0, 1);
+		Character->Dodge();
+		break;
+	case 70:
+		Character->Defence_Begin();
+		break;
+	case 85:
+		if (Character->bIsDefencing)
+		{
+			Character->Defence_End();
+		}
+		break;
+	default:
+		break;
+	}
+
+	static const TArray<TEnumAsByte<EObjectTypeQuery>> NoObjectTypes;
+	static const TArray<AActor*> NoActorsToIgnore;
+	if (Combatant.bMonster)
+	{
+		if ((Frame + Index) % 15 == 0 && Perceptions[Index])
+		{
+			const FVector Start = Character->GetActorLocation();
+			Perceptions[Index]->CheckEnemy(Start, Start, 1000.f, NoObjectTypes, false, UEngineTypes::ConvertToTraceType(ECC_Visibility), NoActorsToIgnore, EDrawDebugTrace::None, true, FLinearColor::Red, FLinearColor::Green, 0.f);
+		}
+	}
+	else if ((Frame + Index) % 10 == 0)
+	{
+		CastChecked<ALyhActDemoCharacter>(Character)->CheckAI(60.f, 1000.f, NoObjectTypes, false, NoActorsToIgnore, EDrawDebugTrace::None, true, FLinearColor::Red, FLinearColor::Green, 0.f);
+	}
+}
+
+void UCombatBenchmarkCommandlet::Respawn(UWorld* World, FBenchCombatant& Combatant)
+{
+	if (Combatant.bMonster)
+	{
+		AAICharacter* Monster = Cast<AAICharacter>(Combatant.Character);
+		if (!Monster || Monster->IsPooled())
+		{
+			Combatant.Character = SpawnCombatant(World, Combatant.Class, Combatant.Home, true);
+		}
+	}
+	else if (Combatant.Character && Combatant.Character->GetCombatStats().Blood <= 0)
+	{
+		Combatant.Character->ResetCombatState();
+	}
+}
+
+int32 UCombatBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 NumMonsters = 200;
+	int32 NumPlayers = 4;
+	int32 NumFrames = 1800;
+	int32 NumWarmupFrames = 30;
+	int32 Seed = 1;
+	float DeltaTime = 1.f / 30.f;
+	FString MonsterClassPath = CombatBenchmark::DefaultMonsterClass;
+	FString PlayerClassPath = CombatBenchmark::DefaultPlayerClass;
+	FString MontagesPath;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmark/CombatBenchmark.csv");
+	FParse::Value(*Params, TEXT("Monsters="), NumMonsters);
+	FParse::Value(*Params, TEXT("Players="), NumPlayers);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Warmup="), NumWarmupFrames);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+	FParse::Value(*Params, TEXT("MonsterClass="), MonsterClassPath);
+	FParse::Value(*Params, TEXT("PlayerClass="), PlayerClassPath);
+	FParse::Value(*Params, TEXT("Montages="), MontagesPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	UClass* MonsterClass = LoadClass<AAICharacter>(nullptr, *MonsterClassPath);
+	UClass* PlayerClass = LoadClass<ALyhActDemoCharacter>(nullptr, *PlayerClassPath);
+	MontageOverride = MontagesPath.IsEmpty() ? nullptr : LoadObject<UCombatMontageSet>(nullptr, *MontagesPath);
+	if (!MonsterClass || !PlayerClass || (!MontagesPath.IsEmpty() && !MontageOverride))
+	{
+		UE_LOG(LogLyhCombat, Error, TEXT("CombatBenchmark: could not load the monster class %s, player class %s or montage set %s"), *MonsterClassPath, *PlayerClassPath, *MontagesPath);
+		return 1;
+	}
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CombatBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->GetWorldSettings()->NotifyBeginPlay();
+	// One combat step per frame, so the fight does not depend on how fast this machine is
+	if (ACombatManager* Manager = ACombatManager::Get(World))
+	{
+		Manager->SetFixedStep(true, FMath::RoundToInt(1.f / DeltaTime), Seed);
+	}
+
+	// Square grid around the origin with the players spread evenly through the monsters
+	const int32 NumCombatants = NumMonsters + NumPlayers;
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt((float)NumCombatants));
+	const int32 PlayerStride = NumPlayers > 0 ? FMath::Max(NumCombatants / NumPlayers, 1) : 0;
+	int32 PlayersLeft = NumPlayers;
+	Combatants.Reset(NumCombatants);
+	Perceptions.Reset(NumCombatants);
+	for (int32 Index = 0; Index < NumCombatants; ++Index)
+	{
+		FBenchCombatant Combatant;
+		Combatant.bMonster = !(PlayersLeft > 0 && (Index % PlayerStride == PlayerStride / 2 || NumCombatants - Index <= PlayersLeft));
+		PlayersLeft -= Combatant.bMonster ? 0 : 1;
+		Combatant.Class = Combatant.bMonster ? MonsterClass : PlayerClass;
+		const FVector Location((Index % Side - Side / 2) * CombatBenchmark::Spacing, (Index / Side - Side / 2) * CombatBenchmark::Spacing, 100.f);
+		Combatant.Home = FTransform(FRotator(0.f, FMath::FRandRange(-180.f, 180.f), 0.f), Location);
+		Combatant.Character = SpawnCombatant(World, Combatant.Class, Combatant.Home, Combatant.bMonster);
+		Combatants.Add(Combatant);
+		Perceptions.Add(Combatant.bMonster ? NewObject<ULyhBTService>(Combatant.Character) : nullptr);
+		if (Index == 0 && Combatant.Character && !Combatant.Character->Montages)
+		{
+			UE_LOG(LogLyhCombat, Warning, TEXT("CombatBenchmark: %s has no montage set, attacks, hits and dodges will not run. Pass -Montages="), *Combatant.Class->GetName());
+		}
+	}
+
+	TArray<double> FrameMs;
+	FrameMs.Reserve(NumFrames);
+	FCombatCounters Totals;
+	FString Csv = TEXT("Frame,FrameMs");
+	for (int32 Counter = 0; Counter < (int32)ECombatCounter::Num; ++Counter)
+	{
+		const TCHAR* Name = FCombatCounters::GetName((ECombatCounter)Counter);
+		Csv += FString::Printf(TEXT(",%sMs,%sCalls"), Name, Name);
+	}
+	Csv += TEXT(",Hits,Traces,LockOnTraces,StateTimers,Mallocs,UsedMB\n");
+
+	uint64 StartUsedPhysical = 0;
+	uint64 StartMallocCalls = 0;
+	for (int32 Frame = -NumWarmupFrames; Frame < NumFrames; ++Frame)
+	{
+		if (Frame == 0)
+		{
+			GCombatCounters.Reset();
+			StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+			StartMallocCalls = CombatBenchmark::GetMallocCalls();
+		}
+		const uint64 FrameMallocCalls = CombatBenchmark::GetMallocCalls();
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < Combatants.Num(); ++Index)
+		{
+			DriveCombatant(Combatants[Index], Index, Frame + NumWarmupFrames);
+		}
+		FApp::SetDeltaTime(DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		for (FBenchCombatant& Combatant : Combatants)
+		{
+			Respawn(World, Combatant);
+		}
+		GFrameCounter++;
+		const double Ms = CombatBenchmark::ToMs(FPlatformTime::Cycles64() - StartCycles);
+		const uint64 Mallocs = CombatBenchmark::GetMallocCalls() - FrameMallocCalls;
+		if (Frame < 0)
+		{
+			continue;
+		}
+
+		FrameMs.Add(Ms);
+		Csv += FString::Printf(TEXT("%d,%.4f"), Frame, Ms);
+		for (int32 Counter = 0; Counter < (int32)ECombatCounter::Num; ++Counter)
+		{
+			Csv += FString::Printf(TEXT(",%.4f,%u"), CombatBenchmark::ToMs(GCombatCounters.Cycles[Counter]), GCombatCounters.Calls[Counter]);
+			Totals.Cycles[Counter] += GCombatCounters.Cycles[Counter];
+			Totals.Calls[Counter] += GCombatCounters.Calls[Counter];
+		}
+		Csv += FString::Printf(TEXT(",%u,%u,%u,%u,%llu,%.2f\n"), GCombatCounters.Hits, GCombatCounters.Traces, GCombatCounters.LockOnTraces, GCombatCounters.StateTimers, Mallocs, FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0));
+		Totals.Hits += GCombatCounters.Hits;
+		Totals.Traces += GCombatCounters.Traces;
+		Totals.LockOnTraces += GCombatCounters.LockOnTraces;
+		Totals.StateTimers += GCombatCounters.StateTimers;
+		GCombatCounters.Reset();
+	}
+	const FPlatformMemoryStats EndMemory = FPlatformMemory::GetStats();
+	const uint64 TotalMallocs = CombatBenchmark::GetMallocCalls() - StartMallocCalls;
+
+	TArray<double> Sorted = FrameMs;
+	Sorted.Sort();
+	double TotalMs = 0.0;
+	for (double Ms : FrameMs)
+	{
+		TotalMs += Ms;
+	}
+	const int32 Measured = FMath::Max(FrameMs.Num(), 1);
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatBenchmark: Monsters=%d Players=%d Frames=%d DeltaTime=%.4f Seed=%d"), NumMonsters, NumPlayers, FrameMs.Num(), DeltaTime, Seed);
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatBenchmark: FrameMs Avg=%.3f Min=%.3f P50=%.3f P95=%.3f P99=%.3f Max=%.3f"),
+		TotalMs / Measured, Sorted.Num() ? Sorted[0] : 0.0, CombatBenchmark::Percentile(Sorted, 0.5f), CombatBenchmark::Percentile(Sorted, 0.95f),
+		CombatBenchmark::Percentile(Sorted, 0.99f), Sorted.Num() ? Sorted.Last() : 0.0);
+	for (int32 Counter = 0; Counter < (int32)ECombatCounter::Num; ++Counter)
+	{
+		UE_LOG(LogLyhCombat, Display, TEXT("CombatBenchmark: %s TotalMs=%.3f PerFrameMs=%.4f Calls=%u"), FCombatCounters::GetName((ECombatCounter)Counter),
+			CombatBenchmark::ToMs(Totals.Cycles[Counter]), CombatBenchmark::ToMs(Totals.Cycles[Counter]) / Measured, Totals.Calls[Counter]);
+	}
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatBenchmark: Hits=%u Traces=%u LockOnTraces=%u StateTimers=%u Mallocs=%llu MallocsPerFrame=%.1f UsedMBDelta=%.2f PeakUsedMB=%.2f"), Totals.Hits, Totals.Traces, Totals.LockOnTraces, Totals.StateTimers,
+		TotalMallocs, (double)TotalMallocs / Measured, ((double)EndMemory.UsedPhysical - (double)StartUsedPhysical) / (1024.0 * 1024.0), EndMemory.PeakUsedPhysical / (1024.0 * 1024.0));
+	if (FFileHelper::SaveStringToFile(Csv, *OutputPath))
+	{
+		UE_LOG(LogLyhCombat, Display, TEXT("CombatBenchmark: per frame numbers written to %s"), *OutputPath);
+	}
+
+	Combatants.Reset();
+	Perceptions.Reset();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return 0;
+}
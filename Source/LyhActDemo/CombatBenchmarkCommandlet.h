@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatBenchmarkCommandlet.generated.h"
+
+class ACombatCharacter;
+class ULyhBTService;
+
+/**
+ * Headless combat benchmark. Spawns players and monsters in an empty world, drives a fixed combat
+ * script (combos, hits, dodges, defence, perception) for a number of frames and reports the game
+ * thread time per frame, the time inside the combat hot paths, the allocator calls and the memory growth.
+ *
+ *   UE4Editor-Cmd LyhActDemo.uproject -run=CombatBenchmark -nullrhi -unattended
+ *       [-Monsters=200] [-Players=4] [-Frames=1800] [-Warmup=30] [-DeltaTime=0.0333] [-Seed=1]
+ *       [-MonsterClass=/Game/AI/BP_AICharacter.BP_AICharacter_C] [-PlayerClass=/Game/Common/ThirdPersonCharacter.ThirdPersonCharacter_C]
+ *       [-Montages=/Game/...] [-Output=Saved/Benchmark/CombatBenchmark.csv]
+ *
+ * Warmup frames run the script before the measured frames and are not reported. The classes default
+ * to the game's Blueprints, the native classes have no montages to attack, dodge or react with.
+ *
+ * Every run with the same arguments plays the same script, so numbers of two builds compare.
+ */
+UCLASS()
+class UCombatBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UCombatBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+private:
+	struct FBenchCombatant
+	{
+		ACombatCharacter* Character;
+		UClass* Class;
+		FTransform Home;
+		bool bMonster;
+	};
+
+	/** Plays the script of one combatant for Frame */
+	void DriveCombatant(FBenchCombatant& Combatant, int32 Index, int32 Frame);
+	/** Brings dead characters back so the population stays constant */
+	void Respawn(UWorld* World, FBenchCombatant& Combatant);
+	ACombatCharacter* SpawnCombatant(UWorld* World, UClass* Class, const FTransform& Transform, bool bMonster);
+
+	TArray<FBenchCombatant> Combatants;
+	/** Enemy check of every monster, parallel to Combatants, null for players */
+	UPROPERTY()
+	TArray<ULyhBTService*> Perceptions;
+	UPROPERTY()
+	class UCombatMontageSet* MontageOverride;
+};
@@ -0,0 +1,639 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatCharacter.h"
+#include "LyhActDemo.h"
+#include "CombatManager.h"
+#include "CombatMontageSet.h"
+#include "CombatProfiling.h"
+#include "CombatStatsRegistry.h"
+#include "HitReactionTable.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+ACombatCharacter::ACombatCharacter()
+{
+	bIsDodging = false;
+	bIsDefencing = false;
+	bIsDeath = false;
+	bIsAttacking = false;
+	bIsAttacked = false;
+	bCanDamage = false;
+	bInCancelWindow = false;
+
+	Montages = nullptr;
+	MontageLoadPriority = FStreamableManager::DefaultAsyncLoadPriority;
+	DodgeMagicCost = 0;
+	DefenceMagicCost = 0;
+	DodgeRecoverTime = 0.f;
+	InputBufferTime = 0.3f;
+}
+
+void ACombatCharacter::PostLoad()
+{
+	Super::PostLoad();
+	if (!Montages && HasAnyFlags(RF_ClassDefaultObject))
+	{
+		MigrateDeprecatedMontages();
+	}
+}
+
+void ACombatCharacter::MigrateDeprecatedMontages()
+{
+	UAnimMontage* const Deprecated[] = { Fast_One_DEPRECATED, Fast_Two_DEPRECATED, Fast_Three_DEPRECATED, Hit_Back_DEPRECATED,
+		Hit_HeadTop_Left_DEPRECATED, Hit_HeadTop_Right_DEPRECATED, Hit_HeadDown_Left_DEPRECATED, Hit_HeadDown_Right_DEPRECATED,
+		Hit_Torso_Left_DEPRECATED, Hit_Torso_Right_DEPRECATED, Hit_Torso_Front_DEPRECATED, Hit_Leg_Left_DEPRECATED, Hit_Leg_Right_DEPRECATED,
+		Dodge_Left_DEPRECATED, Dodge_Right_DEPRECATED, Dodge_Behind_DEPRECATED, Defence_Start_DEPRECATED, Defence_Succeed_DEPRECATED };
+	bool bAnySet = false;
+	for (UAnimMontage* Montage : Deprecated)
+	{
+		bAnySet |= Montage != nullptr;
+	}
+	if (!bAnySet)
+	{
+		return;
+	}
+
+	// Outer is the class defaults, so the set is saved with the Blueprint the next time it is
+	UCombatMontageSet* Set = NewObject<UCombatMontageSet>(this, TEXT("MigratedMontages"));
+	Set->Fast_One = Fast_One_DEPRECATED;
+	Set->Fast_Two = Fast_Two_DEPRECATED;
+	Set->Fast_Three = Fast_Three_DEPRECATED;
+	Set->Hit_Torso_Front = Hit_Torso_Front_DEPRECATED;
+	Set->Dodge_Left = Dodge_Left_DEPRECATED;
+	Set->Dodge_Right = Dodge_Right_DEPRECATED;
+	Set->Dodge_Behind = Dodge_Behind_DEPRECATED;
+	Set->Defence_Start = Defence_Start_DEPRECATED;
+	Set->Defence_Succeed = Defence_Succeed_DEPRECATED;
+
+	// The default zones are the bands and damage the old OnAttacked hard coded, in the same order
+	UHitReactionTable* HitReactions = NewObject<UHitReactionTable>(Set, TEXT("MigratedHitReactions"));
+	UAnimMontage* const Lefts[] = { Hit_HeadTop_Left_DEPRECATED, Hit_HeadDown_Left_DEPRECATED, Hit_Torso_Left_DEPRECATED, Hit_Leg_Left_DEPRECATED };
+	UAnimMontage* const Centers[] = { nullptr, nullptr, Hit_Torso_Front_DEPRECATED, nullptr };
+	UAnimMontage* const Rights[] = { Hit_HeadTop_Right_DEPRECATED, Hit_HeadDown_Right_DEPRECATED, Hit_Torso_Right_DEPRECATED, Hit_Leg_Right_DEPRECATED };
+	for (int32 Index = 0; Index < HitReactions->Zones.Num() && Index < ARRAY_COUNT(Lefts); ++Index)
+	{
+		FHitZone& Zone = HitReactions->Zones[Index];
+		Zone.Back = Hit_Back_DEPRECATED;
+		Zone.FrontLeft = Lefts[Index];
+		Zone.FrontCenter = Centers[Index];
+		Zone.FrontRight = Rights[Index];
+	}
+	HitReactions->BuildLookup();
+	Set->HitReactions = HitReactions;
+	Montages = Set;
+	UE_LOG(LogLyhCombat, Log, TEXT("%s: moved the montage properties into %s, resave the Blueprint to keep it"), *GetClass()->GetName(), *Set->GetPathName());
+}
+
+void ACombatCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		return;
+	}
+
+	// Resolve the row name on the class defaults so only the first instance of a class pays for it
+	ACombatCharacter* Defaults = GetClass()->GetDefaultObject<ACombatCharacter>();
+	if (Defaults->StatsId == INDEX_NONE)
+	{
+		Defaults->StatsId = FCombatStatsRegistry::Get().FindStatsId(StatsRow);
+	}
+	StatsId = Defaults->StatsId;
+	GetCombatStats() = GetBaseStats();
+}
+
+const FPlayerStats& ACombatCharacter::GetBaseStats() const
+{
+	return FCombatStatsRegistry::Get().GetBaseStats(StatsId);
+}
+
+void ACombatCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+	if (!Montages && !StreamedMontages.IsNull())
+	{
+		// Actions check for Montages and wait until the set has arrived
+		TWeakObjectPtr<ACombatCharacter> WeakThis(this);
+		UCombatMontageSet::Preload(StreamedMontages, MontageLoadPriority, FStreamableDelegate::CreateLambda([WeakThis]()
+		{
+			if (ACombatCharacter* Character = WeakThis.Get())
+			{
+				Character->Montages = Character->StreamedMontages.Get();
+			}
+		}));
+	}
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->RegisterCombatant(this);
+	}
+}
+
+void ACombatCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->UnregisterCombatant(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACombatCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	DOREPLIFETIME(ACombatCharacter, CombatState);
+	DOREPLIFETIME(ACombatCharacter, CombatMontage);
+}
+
+void ACombatCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+	const uint8 Flags = bIsDodging | bIsDefencing << 1 | bIsDeath << 2 | bIsAttacking << 3 | bIsAttacked << 4 | bCanDamage << 5;
+	const FPlayerStats& Stats = GetCombatStats();
+	CombatState.Set(Flags, ComboNum, Stats.Blood, Stats.Magic);
+}
+
+void ACombatCharacter::OnRep_CombatState()
+{
+	const uint8 Flags = CombatState.GetFlags();
+	bIsDodging = (Flags & 1) != 0;
+	bIsDefencing = (Flags & 2) != 0;
+	bIsDeath = (Flags & 4) != 0;
+	bIsAttacking = (Flags & 8) != 0;
+	bIsAttacked = (Flags & 16) != 0;
+	bCanDamage = (Flags & 32) != 0;
+	ComboNum = CombatState.GetComboNum();
+	FPlayerStats& Stats = GetCombatStats();
+	Stats.Blood = CombatState.GetBlood();
+	Stats.Magic = CombatState.GetMagic();
+}
+
+float ACombatCharacter::PlayCombatMontage(UAnimMontage* Montage)
+{
+	const uint8 Id = Montages ? Montages->GetMontageId(Montage) : 0;
+	if (Role == ROLE_Authority && Montages)
+	{
+		CombatMontage.Set(Id, GetWorld()->GetTimeSeconds());
+		// Monsters in a slow replication tier still show their attacks on time
+		ForceNetUpdate();
+	}
+	return PlayMontageLocally(Montage, Montages && Montages->IsHitReactionId(Id));
+}
+
+float ACombatCharacter::SwitchCombatMontage(UAnimMontage* Montage)
+{
+	// Montage_Play blends out the montage of the same slot group with the blend in time of the new one
+	if (Montage)
+	{
+		return PlayCombatMontage(Montage);
+	}
+	StopCombatMontages();
+	return 0.f;
+}
+
+float ACombatCharacter::PlayMontageLocally(UAnimMontage* Montage, bool bHitReaction)
+{
+	// Crowds take hit after hit; rewinding keeps one montage instance alive instead of blending
+	// out the old one and allocating a new one per hit
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (bHitReaction && Montage && AnimInstance && AnimInstance->Montage_IsPlaying(Montage))
+	{
+		AnimInstance->Montage_SetPosition(Montage, 0.f);
+		return Montage->GetPlayLength() / FMath::Max(Montage->RateScale, KINDA_SMALL_NUMBER);
+	}
+	return PlayAnimMontage(Montage);
+}
+
+void ACombatCharacter::StopCombatMontages()
+{
+	if (Role == ROLE_Authority)
+	{
+		CombatMontage.Set(0, GetWorld()->GetTimeSeconds());
+	}
+	GetMesh()->Stop();
+}
+
+void ACombatCharacter::OnRep_CombatMontage()
+{
+	if (UAnimMontage* Montage = Montages ? Montages->GetMontageById(CombatMontage.Id) : nullptr)
+	{
+		// The first bunch of a character that just became relevant carries whatever the server played last
+		const AGameStateBase* GameState = GetWorld()->GetGameState();
+		const float Elapsed = GameState ? GameState->GetServerWorldTimeSeconds() - CombatMontage.StartTime : 0.f;
+		if (Elapsed < Montage->GetPlayLength() / FMath::Max(Montage->RateScale, KINDA_SMALL_NUMBER))
+		{
+			PlayMontageLocally(Montage, Montages->IsHitReactionId(CombatMontage.Id));
+		}
+	}
+	else
+	{
+		GetMesh()->Stop();
+	}
+}
+
+void ACombatCharacter::StartCombatTimer(float& EndTime, float Duration)
+{
+	COMBAT_COUNTER_INC(StateTimers);
+	// Like SetTimer, a non positive duration just clears it
+	if (Duration <= 0.f)
+	{
+		EndTime = 0.f;
+	}
+	else if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		EndTime = Manager->GetCombatTimeAfter(Duration);
+	}
+	else
+	{
+		EndTime = GetWorld()->GetTimeSeconds() + Duration;
+	}
+}
+
+FCombatReplayRecorder* ACombatCharacter::GetReplayRecorder() const
+{
+	ACombatManager* Manager = ACombatManager::Get(this);
+	return Manager ? Manager->GetReplayRecorder() : nullptr;
+}
+
+float ACombatCharacter::GetCombatTime() const
+{
+	const ACombatManager* Manager = ACombatManager::Get(this);
+	return Manager ? Manager->GetCombatTime() : GetWorld()->GetTimeSeconds();
+}
+
+void ACombatCharacter::AdvanceCombatState(float Now)
+{
+	if (ComboEndTime > 0.f && Now >= ComboEndTime)
+	{
+		OnAttackComplete();
+	}
+	if (DodgeEndTime > 0.f && Now >= DodgeEndTime)
+	{
+		OnDodgeComplete();
+	}
+	if (HurtEndTime > 0.f && Now >= HurtEndTime)
+	{
+		OnHurtComplete();
+	}
+	ConsumeBufferedInput();
+}
+
+void ACombatCharacter::ResetCombatState()
+{
+	bIsDodging = false;
+	bIsDefencing = false;
+	bIsDeath = false;
+	bIsAttacking = false;
+	bIsAttacked = false;
+	bCanDamage = false;
+	bInCancelWindow = false;
+	InputBuffer.Clear();
+	ComboNum = 0;
+	ComboEndTime = 0.f;
+	DodgeEndTime = 0.f;
+	HurtEndTime = 0.f;
+	GetCombatStats() = GetBaseStats();
+}
+
+void ACombatCharacter::AttackEnemy()
+{
+	COMBAT_COUNTER_SCOPE(AttackEnemy);
+	// Player attacks are recorded as inputs, what is left are the decisions of behavior trees
+	if (!IsPlayerControlled() && Role == ROLE_Authority)
+	{
+		if (FCombatReplayRecorder* Replay = GetReplayRecorder())
+		{
+			Replay->RecordAttack(this);
+		}
+	}
+	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked || !Montages || !CanStartAttack())
+	{
+		return;
+	}
+	bIsAttacking = true;
+	bCanDamage = false;
+
+	switch (ComboNum)
+	{
+	case 0:
+		if (Montages->Fast_One)
+		{
+			float Deruction = PlayCombatMontage(Montages->Fast_One);
+			SwingId++;
+			ComboNum++;
+			StartCombatTimer(ComboEndTime, Deruction);
+		}
+		break;
+	case 1:
+		if (Montages->Fast_Two)
+		{
+			ComboEndTime = 0.f;
+			float Deruction = PlayCombatMontage(Montages->Fast_Two);
+			SwingId++;
+			ComboNum++;
+			StartCombatTimer(ComboEndTime, Deruction);
+		}
+		break;
+	case 2:
+		if (Montages->Fast_Three)
+		{
+			ComboEndTime = 0.f;
+			float Deruction = PlayCombatMontage(Montages->Fast_Three);
+			SwingId++;
+			ComboNum = 0;
+			// Ends the combo like the other swings, OnAttackComplete gives the attack token back
+			StartCombatTimer(ComboEndTime, Deruction);
+		}
+		break;
+	}
+}
+
+void ACombatCharacter::BufferInput(ECombatInput Input)
+{
+	if (Role < ROLE_Authority)
+	{
+		ServerBufferInput(Input, LeftVector, RightVextor);
+		return;
+	}
+	if (FCombatReplayRecorder* Replay = GetReplayRecorder())
+	{
+		Replay->RecordInput(this, Input);
+	}
+	InputBuffer.Press(Input, GetCombatTime());
+	ConsumeBufferedInput();
+}
+
+void ACombatCharacter::ServerBufferInput_Implementation(ECombatInput Input, int8 InLeftVector, int8 InRightVector)
+{
+	// Dodges go the way the client was steering
+	LeftVector = InLeftVector;
+	RightVextor = InRightVector;
+	BufferInput(Input);
+}
+
+bool ACombatCharacter::ServerBufferInput_Validate(ECombatInput Input, int8 InLeftVector, int8 InRightVector)
+{
+	return Input < ECombatInput::Num;
+}
+
+void ACombatCharacter::ReleaseDefence()
+{
+	if (Role < ROLE_Authority)
+	{
+		ServerReleaseDefence();
+		return;
+	}
+	if (FCombatReplayRecorder* Replay = GetReplayRecorder())
+	{
+		Replay->RecordReleaseDefence(this);
+	}
+	InputBuffer.Consume(ECombatInput::Defence);
+	Defence_End();
+}
+
+void ACombatCharacter::ServerReleaseDefence_Implementation()
+{
+	ReleaseDefence();
+}
+
+bool ACombatCharacter::ServerReleaseDefence_Validate()
+{
+	return true;
+}
+
+void ACombatCharacter::OpenCancelWindow()
+{
+	bInCancelWindow = true;
+	ConsumeBufferedInput();
+}
+
+void ACombatCharacter::CloseCancelWindow()
+{
+	bInCancelWindow = false;
+}
+
+void ACombatCharacter::ConsumeBufferedInput()
+{
+	if (InputBuffer.IsEmpty() || bIsDeath)
+	{
+		return;
+	}
+	const float Now = GetCombatTime();
+	InputBuffer.Expire(Now, InputBufferTime);
+	if (InputBuffer.IsEmpty())
+	{
+		return;
+	}
+	// A dodge cuts into anything it can, it is how the player gets out of trouble
+	if (InputBuffer.IsBuffered(ECombatInput::Dodge, Now, InputBufferTime) && !bIsDodging)
+	{
+		Dodge();
+		if (bIsDodging)
+		{
+			InputBuffer.Clear();
+			return;
+		}
+	}
+	if (InputBuffer.IsBuffered(ECombatInput::Attack, Now, InputBufferTime) && (!bIsAttacking || bInCancelWindow))
+	{
+		// Inside the window the next swing of the combo starts right away instead of after the montage
+		const uint32 LastSwingId = SwingId;
+		const bool bWasAttacking = bIsAttacking;
+		const bool bWasInCancelWindow = bInCancelWindow;
+		bIsAttacking = false;
+		bInCancelWindow = false;
+		AttackEnemy();
+		if (SwingId != LastSwingId)
+		{
+			InputBuffer.Consume(ECombatInput::Attack);
+			return;
+		}
+		// The swing did not start, the window stays open for the next try
+		bIsAttacking = bWasAttacking;
+		bInCancelWindow = bWasInCancelWindow;
+	}
+	if (InputBuffer.IsBuffered(ECombatInput::Defence, Now, InputBufferTime) && !bIsDefencing)
+	{
+		Defence_Begin();
+		if (bIsDefencing)
+		{
+			InputBuffer.Consume(ECombatInput::Defence);
+		}
+	}
+}
+
+void ACombatCharacter::Dodge()
+{
+	COMBAT_COUNTER_SCOPE(Dodge);
+	FPlayerStats& Stats = GetCombatStats();
+	if (bIsDefencing || GetMovementComponent()->IsFalling() || bIsDodging || !Montages || (DodgeMagicCost > 0 && Stats.Magic < DodgeMagicCost))
+	{
+		return;
+	}
+	Stats.Magic -= DodgeMagicCost;
+	if (bIsAttacking)
+	{
+		OnAttackComplete();
+		bIsAttacking = false;
+		bCanDamage = false;
+	}
+	bIsAttacked = false;
+	HurtEndTime = 0.f;
+	bIsDodging = true;
+	UAnimMontage* DodgeMontage = Montages->Dodge_Behind;
+	if (RightVextor > LeftVector)
+	{
+		DodgeMontage = Montages->Dodge_Right;
+	}
+	else if (RightVextor < LeftVector)
+	{
+		DodgeMontage = Montages->Dodge_Left;
+	}
+	const float Duration = SwitchCombatMontage(DodgeMontage);
+	StartCombatTimer(DodgeEndTime, Duration - DodgeRecoverTime);
+}
+
+void ACombatCharacter::OnAttacked(FVector AttackPoint)
+{
+	OnAttackedBy(AttackPoint, nullptr);
+}
+
+void ACombatCharacter::OnAttackedBy(FVector AttackPoint, ACombatCharacter* Attacker)
+{
+	if (Role < ROLE_Authority)
+	{
+		return;
+	}
+	COMBAT_COUNTER_SCOPE(OnAttacked);
+	COMBAT_COUNTER_INC(Hits);
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		if (!Manager->AcceptsHit())
+		{
+			return;
+		}
+		if (FCombatReplayRecorder* Replay = Manager->GetReplayRecorder())
+		{
+			Replay->RecordHit(this, Attacker, AttackPoint);
+		}
+		Manager->GetDamageQueue().Add(this, Attacker, AttackPoint);
+	}
+	else
+	{
+		TArray<FVector> AttackPoints;
+		AttackPoints.Add(AttackPoint);
+		ResolveHits(AttackPoints);
+	}
+}
+
+void ACombatCharacter::ResolveHits(const TArray<FVector>& AttackPoints)
+{
+	COMBAT_COUNTER_SCOPE(ResolveHits);
+	if (bIsDodging || !Montages)
+	{
+		return;
+	}
+	if (bIsDefencing)
+	{
+		if (Montages->Defence_Succeed)
+		{
+			PlayCombatMontage(Montages->Defence_Succeed);
+		}
+		Defence_End();
+	}
+	else
+	{
+		if (bIsAttacking)
+		{
+			bIsAttacking = false;
+			bCanDamage = false;
+		}
+		bIsAttacked = true;
+		StartCombatTimer(HurtEndTime, 1.5f);
+		FPlayerStats& Stats = GetCombatStats();
+		UAnimMontage* ReactionMontage = nullptr;
+		// Sets without a table get the default zones, a character never ignores damage
+		if (const UHitReactionTable* HitReactions = Montages->HitReactions ? Montages->HitReactions : GetDefault<UHitReactionTable>())
+		{
+			// Damage of every hit adds up, the strongest hit picks the reaction
+			const FTransform CharacterTrans = GetActorTransform();
+			FHitReaction Strongest;
+			int32 TotalDamage = 0;
+			for (const FVector& AttackPoint : AttackPoints)
+			{
+				FHitReaction Reaction;
+				HitReactions->Resolve(CharacterTrans, AttackPoint, Reaction);
+				if (TotalDamage == 0 || Reaction.Damage > Strongest.Damage)
+				{
+					Strongest = Reaction;
+				}
+				TotalDamage += Reaction.Damage;
+			}
+			ReactionMontage = Strongest.Montage;
+			Stats.Blood -= TotalDamage;
+		}
+		// Zones without a montage still show a hit, only a set without any hit montage stops the current one
+		SwitchCombatMontage(ReactionMontage ? ReactionMontage : Montages->Hit_Torso_Front);
+		if (Stats.Blood <= 0)
+		{
+			DeathToReborn();
+		}
+	}
+}
+
+void ACombatCharacter::OnAttackComplete()
+{
+	ComboEndTime = 0.f;
+	ComboNum = 0;
+	// Bounced combos end here as well
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->GetAttackTokens().Release(this);
+	}
+}
+
+void ACombatCharacter::OnDodgeComplete()
+{
+	bIsDodging = false;
+	DodgeEndTime = 0.f;
+}
+
+void ACombatCharacter::OnHurtComplete()
+{
+	bIsAttacked = false;
+	HurtEndTime = 0.f;
+}
+
+void ACombatCharacter::Defence_Begin()
+{
+	FPlayerStats& Stats = GetCombatStats();
+	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked || (DefenceMagicCost > 0 && Stats.Magic < DefenceMagicCost))
+	{
+		return;
+	}
+	Stats.Magic -= DefenceMagicCost;
+	bIsDefencing = true;
+	OnDefenceBegin();
+	if (Montages && Montages->Defence_Start)
+	{
+		PlayCombatMontage(Montages->Defence_Start);
+	}
+	GetCharacterMovement()->MaxWalkSpeed = 200;
+}
+
+void ACombatCharacter::Defence_End()
+{
+	bIsDefencing = false;
+	OnDefenceEnd();
+	GetCharacterMovement()->MaxWalkSpeed = 600;
+}
+
+void ACombatCharacter::OnBounced()
+{
+	bIsAttacking = false;
+	SwitchCombatMontage(Montages ? Montages->Hit_Torso_Front : nullptr);
+	OnAttackComplete();
+}
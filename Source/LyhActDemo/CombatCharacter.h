@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Character.h"
+#include "PlayerStats.h"
+#include "CombatInputBuffer.h"
+#include "CombatReplication.h"
+#include "CombatCharacter.generated.h"
+
+class UCombatMontageSet;
+class UAnimMontage;
+class FCombatReplayRecorder;
+
+/**
+ * Combat state machine shared by the player and the monsters.
+ * Derived classes only provide their stats row and the costs of their actions.
+ */
+UCLASS(abstract, config = Game)
+class LYHACTDEMO_API ACombatCharacter : public ACharacter
+{
+	GENERATED_BODY()
+public:
+	ACombatCharacter();
+public:
+	uint8 ComboNum = 0;
+	/** Bumped by every attack montage, lets the damage queue tell swings apart */
+	uint32 SwingId = 0;
+	int8 LeftVector = 0;
+	int8 RightVextor = 0;
+	/** Row of the stats table this class starts with, resolved to StatsId once per class */
+	UPROPERTY(EditDefaultsOnly, Category = "Combat")
+	FName StatsRow;
+	int32 StatsId = INDEX_NONE;
+	/** Order the combat manager first saw this character in, from 1. Sorts combatants the same way on every run */
+	uint32 CombatantIndex = 0;
+
+	/***********************state********************/
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bIsDodging : 1;
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bIsDefencing : 1;
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bIsDeath : 1;
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bIsAttacking : 1;
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bIsAttacked : 1;
+	UPROPERTY(BlueprintReadWrite, Category = "State")
+	uint8 bCanDamage : 1;
+	/** Inside the combo window of the current attack montage */
+	UPROPERTY(BlueprintReadOnly, Category = "State")
+	uint8 bInCancelWindow : 1;
+	/***********************state********************/
+
+	/** Montage table shared by all instances of the class */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Anim")
+	UCombatMontageSet* Montages;
+
+	/** Montage table streamed in when the first instance begins play, used while Montages is not set */
+	UPROPERTY(EditDefaultsOnly, Category = "Anim")
+	TSoftObjectPtr<UCombatMontageSet> StreamedMontages;
+
+	/** Async load priority of StreamedMontages, higher loads first */
+	UPROPERTY(EditDefaultsOnly, Category = "Anim")
+	int32 MontageLoadPriority;
+
+	/***********montages the character classes used to hold, moved into Montages by PostLoad***********/
+	UPROPERTY()
+	UAnimMontage* Fast_One_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Fast_Two_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Fast_Three_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Back_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_HeadTop_Left_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_HeadTop_Right_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_HeadDown_Left_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_HeadDown_Right_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Torso_Left_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Torso_Right_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Torso_Front_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Leg_Left_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Hit_Leg_Right_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Dodge_Left_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Dodge_Right_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Dodge_Behind_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Defence_Start_DEPRECATED;
+	UPROPERTY()
+	UAnimMontage* Defence_Succeed_DEPRECATED;
+	/***********montages the character classes used to hold, moved into Montages by PostLoad***********/
+
+	/** Magic consumed by a dodge, 0 means dodging is free */
+	UPROPERTY(EditDefaultsOnly, Category = "Combat")
+	int32 DodgeMagicCost;
+
+	/** Magic consumed when starting to defend, 0 means defending is free */
+	UPROPERTY(EditDefaultsOnly, Category = "Combat")
+	int32 DefenceMagicCost;
+
+	/** How much earlier than the end of the dodge montage the character can act again */
+	UPROPERTY(EditDefaultsOnly, Category = "Combat")
+	float DodgeRecoverTime;
+
+	/** How long a press is kept for the next moment the character can act, in seconds */
+	UPROPERTY(EditDefaultsOnly, Category = "Combat")
+	float InputBufferTime;
+
+	/** World time the combo, dodge and hurt states run out at, 0 when not running */
+	float ComboEndTime = 0.f;
+	float DodgeEndTime = 0.f;
+	float HurtEndTime = 0.f;
+public:
+	UFUNCTION(BlueprintCallable)
+	void AttackEnemy();
+	/** Records a press and plays it now, or as soon as the current action allows it within InputBufferTime */
+	UFUNCTION(BlueprintCallable)
+	void BufferInput(ECombatInput Input);
+	/** Drops a buffered defence press and ends the defence, on the server when called on a client */
+	UFUNCTION(BlueprintCallable)
+	void ReleaseDefence();
+	/** Called by the combo window notify of the attack montages */
+	void OpenCancelWindow();
+	void CloseCancelWindow();
+	void Dodge();
+	/** Queues a hit for the end of the frame. Only the server applies hits */
+	UFUNCTION(BlueprintCallable)
+	void OnAttacked(FVector AttackPoint);
+	/** Same as OnAttacked, repeated hits of one swing of Attacker are only counted once */
+	UFUNCTION(BlueprintCallable)
+	void OnAttackedBy(FVector AttackPoint, ACombatCharacter* Attacker);
+	/** Applies all hits this character took in a frame: one reaction, summed damage */
+	void ResolveHits(const TArray<FVector>& AttackPoints);
+	UFUNCTION()
+	void OnAttackComplete();
+	UFUNCTION()
+	void OnDodgeComplete();
+	UFUNCTION()
+	void OnHurtComplete();
+	UFUNCTION()
+	void Defence_Begin();
+	UFUNCTION()
+	void Defence_End();
+	UFUNCTION(BlueprintCallable)
+	void OnBounced();
+	UFUNCTION(BlueprintNativeEvent)
+	void DeathToReborn();
+	virtual void DeathToReborn_Implementation() {}
+
+	/** Clears every combat state and restores the base stats, e.g. when a pooled character comes back */
+	void ResetCombatState();
+
+	/** Ends the states whose time ran out, called for every combatant once per frame by the combat manager */
+	void AdvanceCombatState(float Now);
+
+	/** Shared read-only stats of StatsRow, e.g. the magic regeneration stops at */
+	const FPlayerStats& GetBaseStats() const;
+
+	/** Current stats of this character, starts as a copy of the base stats */
+	virtual FPlayerStats& GetCombatStats() PURE_VIRTUAL(ACombatCharacter::GetCombatStats, static FPlayerStats Dummy; return Dummy;);
+	/** Plays Montage and, on the server, replicates it to the clients as its id in the montage set */
+	float PlayCombatMontage(UAnimMontage* Montage);
+	/** Stops the montages here and on the clients */
+	void StopCombatMontages();
+	/** Blends from whatever plays into Montage instead of stopping first; stops everything when Montage is null */
+	float SwitchCombatMontage(UAnimMontage* Montage);
+
+	virtual void PostLoad() override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+protected:
+	/** Presses of the owning client are played on the server */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerBufferInput(ECombatInput Input, int8 InLeftVector, int8 InRightVector);
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReleaseDefence();
+
+	/** State flags, ComboNum, Blood and Magic as the server last saw them */
+	UPROPERTY(ReplicatedUsing = OnRep_CombatState)
+	FCombatRepState CombatState;
+	UPROPERTY(ReplicatedUsing = OnRep_CombatMontage)
+	FCombatMontageRep CombatMontage;
+
+	UFUNCTION()
+	void OnRep_CombatState();
+	UFUNCTION()
+	void OnRep_CombatMontage();
+
+	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	void StartCombatTimer(float& EndTime, float Duration);
+	/** Clock StartCombatTimer and the input buffer run on, see ACombatManager::GetCombatTime */
+	float GetCombatTime() const;
+	/** Recorder of the world while a combat replay is being recorded, null otherwise */
+	FCombatReplayRecorder* GetReplayRecorder() const;
+	/** Plays Montage on this machine only. A hit reaction that is already playing is rewound instead of restarted */
+	float PlayMontageLocally(UAnimMontage* Montage, bool bHitReaction);
+	/** Plays whatever buffered input the current state allows */
+	void ConsumeBufferedInput();
+	virtual void OnDefenceBegin() {}
+	virtual void OnDefenceEnd() {}
+	/** Last say on whether AttackEnemy may start or continue a combo, after the state checks */
+	virtual bool CanStartAttack() { return true; }
+private:
+	/** Builds a montage set out of the deprecated montage properties of a class saved before the set existed */
+	void MigrateDeprecatedMontages();
+
+	FCombatInputBuffer InputBuffer;
+};
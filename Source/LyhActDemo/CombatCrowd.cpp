@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatCrowd.h"
+#include "MonsterAIController.h"
+#include "AICharacter.h"
+
+namespace CombatCrowd
+{
+	/** Seconds between two rankings of the agents */
+	const float UpdateInterval = 0.5f;
+}
+
+void FCombatCrowd::SetSlots(int32 InNumSlots, float InSlotRadius)
+{
+	NumSlots = FMath::Max(InNumSlots, 1);
+	SlotRadius = InSlotRadius;
+	Rings.Reset();
+}
+
+void FCombatCrowd::Register(AMonsterAIController* Controller)
+{
+	if (!Controller || Agents.ContainsByPredicate([Controller](const FAgent& Agent) { return Agent.Controller == Controller; }))
+	{
+		return;
+	}
+	FAgent Agent;
+	Agent.Controller = Controller;
+	Agent.DistSquared = 0.f;
+	Agent.Active = -1;
+	Agents.Add(Agent);
+}
+
+void FCombatCrowd::Unregister(AMonsterAIController* Controller)
+{
+	ReleaseSlot(Controller);
+	const int32 Index = Agents.IndexOfByPredicate([Controller](const FAgent& Agent) { return Agent.Controller == Controller; });
+	if (Index != INDEX_NONE)
+	{
+		Agents.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+FVector FCombatCrowd::SlotLocation(const AActor* Target, int32 Slot, float Radius) const
+{
+	// Slots keep their world direction, a turning target does not make everyone reshuffle
+	const float Angle = 2.f * PI * Slot / NumSlots;
+	return Target->GetActorLocation() + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Radius;
+}
+
+FVector FCombatCrowd::ClaimSlot(AMonsterAIController* Controller, AActor* Target)
+{
+	const APawn* Pawn = Controller->GetPawn();
+	const FVector From = Pawn ? Pawn->GetActorLocation() : Target->GetActorLocation();
+	FRing* Ring = Rings.Find(Target);
+	if (Ring)
+	{
+		const int32 Held = Ring->Holders.IndexOfByKey(TWeakObjectPtr<AMonsterAIController>(Controller));
+		if (Held != INDEX_NONE)
+		{
+			return SlotLocation(Target, Held, SlotRadius);
+		}
+	}
+	ReleaseSlot(Controller);
+	if (!Ring)
+	{
+		Ring = &Rings.Add(Target);
+		Ring->Holders.SetNum(NumSlots);
+	}
+
+	int32 BestSlot = INDEX_NONE;
+	float BestDistSquared = MAX_flt;
+	for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+	{
+		if (!Ring->Holders[Slot].IsValid())
+		{
+			const float DistSquared = FVector::DistSquared(SlotLocation(Target, Slot, SlotRadius), From);
+			if (DistSquared < BestDistSquared)
+			{
+				BestSlot = Slot;
+				BestDistSquared = DistSquared;
+			}
+		}
+	}
+	if (BestSlot != INDEX_NONE)
+	{
+		Ring->Holders[BestSlot] = Controller;
+		return SlotLocation(Target, BestSlot, SlotRadius);
+	}
+	// Ring is full, wait further out on the side the monster came from
+	const FVector Away = (From - Target->GetActorLocation()).GetSafeNormal2D();
+	return Target->GetActorLocation() + Away * SlotRadius * 2.f;
+}
+
+void FCombatCrowd::ReleaseSlot(AMonsterAIController* Controller)
+{
+	const TWeakObjectPtr<AMonsterAIController> Key(Controller);
+	for (TPair<TWeakObjectPtr<AActor>, FRing>& Pair : Rings)
+	{
+		const int32 Held = Pair.Value.Holders.IndexOfByKey(Key);
+		if (Held != INDEX_NONE)
+		{
+			Pair.Value.Holders[Held] = nullptr;
+			return;
+		}
+	}
+}
+
+void FCombatCrowd::Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations)
+{
+	TimeToUpdate -= DeltaSeconds;
+	if (TimeToUpdate > 0.f)
+	{
+		return;
+	}
+	TimeToUpdate = CombatCrowd::UpdateInterval;
+
+	for (auto It = Rings.CreateIterator(); It; ++It)
+	{
+		if (!It->Key.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	Order.Reset();
+	for (int32 Index = Agents.Num() - 1; Index >= 0; --Index)
+	{
+		FAgent& Agent = Agents[Index];
+		const AMonsterAIController* Controller = Agent.Controller.Get();
+		if (!Controller)
+		{
+			Agents.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+		const AAICharacter* Monster = Cast<AAICharacter>(Controller->GetPawn());
+		Agent.DistSquared = BIG_NUMBER;
+		if (Monster && !Monster->IsPooled())
+		{
+			const FVector Location = Monster->GetActorLocation();
+			for (const FVector& PlayerLocation : PlayerLocations)
+			{
+				Agent.DistSquared = FMath::Min(Agent.DistSquared, FVector::DistSquared(Location, PlayerLocation));
+			}
+		}
+	}
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		Order.Add(Index);
+	}
+	Order.Sort([this](int32 A, int32 B) { return Agents[A].DistSquared < Agents[B].DistSquared; });
+	for (int32 Rank = 0; Rank < Order.Num(); ++Rank)
+	{
+		FAgent& Agent = Agents[Order[Rank]];
+		const int8 Active = Rank < AgentBudget && Agent.DistSquared < BIG_NUMBER ? 1 : 0;
+		// A monster that is moving keeps its state, it is tried again at the next ranking
+		if (Agent.Active != Active && Agent.Controller->SetCrowdAgentActive(Active != 0))
+		{
+			Agent.Active = Active;
+		}
+	}
+}
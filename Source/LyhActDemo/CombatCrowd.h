@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AActor;
+class AMonsterAIController;
+
+/**
+ * Crowd avoidance budget and surround slots of the monsters. Only the monsters closest to a player
+ * hold a detour crowd agent and run full avoidance, the rest use plain path following. Monsters chasing the same target
+ * each claim one of a ring of slots around it instead of all pathing to its centre; when the ring is
+ * full the others wait on a wider ring.
+ */
+class LYHACTDEMO_API FCombatCrowd
+{
+public:
+	void SetAgentBudget(int32 InAgentBudget) { AgentBudget = FMath::Max(InAgentBudget, 0); }
+	void SetSlots(int32 InNumSlots, float InSlotRadius);
+	void Register(AMonsterAIController* Controller);
+	void Unregister(AMonsterAIController* Controller);
+
+	/** Location of Controller's slot around Target, claims the free slot closest to its pawn on first call */
+	FVector ClaimSlot(AMonsterAIController* Controller, AActor* Target);
+	void ReleaseSlot(AMonsterAIController* Controller);
+
+	void Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations);
+private:
+	struct FAgent
+	{
+		TWeakObjectPtr<AMonsterAIController> Controller;
+		float DistSquared;
+		/** -1 unset, 0 no crowd agent, 1 full avoidance. Only set once the controller confirmed the switch */
+		int8 Active;
+	};
+
+	struct FRing
+	{
+		/** Holder of each slot */
+		TArray<TWeakObjectPtr<AMonsterAIController>> Holders;
+	};
+
+	FVector SlotLocation(const AActor* Target, int32 Slot, float Radius) const;
+
+	TArray<FAgent> Agents;
+	TArray<int32> Order;
+	TMap<TWeakObjectPtr<AActor>, FRing> Rings;
+	int32 AgentBudget = 40;
+	int32 NumSlots = 8;
+	float SlotRadius = 150.f;
+	float TimeToUpdate = 0.f;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatDamageQueue.h"
+#include "CombatCharacter.h"
+
+void FCombatDamageQueue::Add(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint)
+{
+	if (!Victim || Victim == Attacker)
+	{
+		return;
+	}
+	FCombatHit Hit;
+	Hit.Victim = Victim;
+	Hit.Attacker = Attacker;
+	Hit.VictimIndex = Victim->CombatantIndex;
+	Hit.SwingId = Attacker ? Attacker->SwingId : 0;
+	Hit.AttackPoint = AttackPoint;
+	PendingHits.Add(Hit);
+}
+
+void FCombatDamageQueue::Reset()
+{
+	PendingHits.Reset();
+	ResolvingHits.Reset();
+	SwingHits.Reset();
+}
+
+bool FCombatDamageQueue::RegisterSwingHit(const FCombatHit& Hit)
+{
+	FSwingVictims& Swing = SwingHits.FindOrAdd(Hit.Attacker);
+	if (Swing.SwingId != Hit.SwingId)
+	{
+		Swing.SwingId = Hit.SwingId;
+		Swing.Victims.Reset();
+	}
+	else if (Swing.Victims.Contains(Hit.Victim))
+	{
+		return false;
+	}
+	Swing.Victims.Add(Hit.Victim);
+	return true;
+}
+
+void FCombatDamageQueue::Resolve()
+{
+	if (PendingHits.Num() == 0)
+	{
+		return;
+	}
+
+	// Reactions may report new hits (e.g. from DeathToReborn), those go to the next frame
+	Exchange(PendingHits, ResolvingHits);
+	// Registration order rather than addresses, so victims die and return to the pool in the same order every run
+	ResolvingHits.StableSort([](const FCombatHit& A, const FCombatHit& B) { return A.VictimIndex < B.VictimIndex; });
+
+	for (int32 First = 0; First < ResolvingHits.Num();)
+	{
+		ACombatCharacter* Victim = ResolvingHits[First].Victim.Get();
+		int32 Last = First + 1;
+		while (Last < ResolvingHits.Num() && ResolvingHits[Last].VictimIndex == ResolvingHits[First].VictimIndex && ResolvingHits[Last].Victim.Get() == Victim)
+		{
+			++Last;
+		}
+
+		if (Victim)
+		{
+			ScratchPoints.Reset();
+			bool bHasAnonymousHit = false;
+			for (int32 Index = First; Index < Last; ++Index)
+			{
+				const FCombatHit& Hit = ResolvingHits[Index];
+				if (!Hit.Attacker.IsValid())
+				{
+					if (bHasAnonymousHit)
+					{
+						continue;
+					}
+					bHasAnonymousHit = true;
+				}
+				else if (!RegisterSwingHit(Hit))
+				{
+					continue;
+				}
+				ScratchPoints.Add(Hit.AttackPoint);
+			}
+			if (ScratchPoints.Num() > 0)
+			{
+				Victim->ResolveHits(ScratchPoints);
+			}
+		}
+		First = Last;
+	}
+	ResolvingHits.Reset();
+
+	for (auto It = SwingHits.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class ACombatCharacter;
+
+/** A hit reported by a weapon, waiting for the end of the frame */
+struct FCombatHit
+{
+	TWeakObjectPtr<ACombatCharacter> Victim;
+	TWeakObjectPtr<ACombatCharacter> Attacker;
+	/** CombatantIndex of the victim, hits are resolved in this order */
+	uint32 VictimIndex;
+	uint32 SwingId;
+	FVector AttackPoint;
+};
+
+/**
+ * Collects the hits of a frame and resolves them in one pass: hits repeated by the same swing are
+ * dropped, the rest are grouped by victim so each victim reacts, loses blood and dies at most once.
+ */
+class LYHACTDEMO_API FCombatDamageQueue
+{
+public:
+	/** Attacker may be null when the caller does not know it; such hits only count once per victim per frame */
+	void Add(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint);
+	void Resolve();
+	void Reset();
+	int32 Num() const { return PendingHits.Num(); }
+private:
+	/** Returns false if Attacker already hit Victim during its current swing */
+	bool RegisterSwingHit(const FCombatHit& Hit);
+
+	struct FSwingVictims
+	{
+		uint32 SwingId = 0;
+		TArray<TWeakObjectPtr<ACombatCharacter>> Victims;
+	};
+
+	TArray<FCombatHit> PendingHits;
+	TArray<FCombatHit> ResolvingHits;
+	TArray<FVector> ScratchPoints;
+	TMap<TWeakObjectPtr<ACombatCharacter>, FSwingVictims> SwingHits;
+};
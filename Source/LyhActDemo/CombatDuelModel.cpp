@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatDuelModel.h"
+#include "LyhActDemo.h"
+#include "CombatCharacter.h"
+#include "CombatMontageSet.h"
+#include "CombatStatsRegistry.h"
+#include "HitReactionTable.h"
+#include "Animation/AnimMontage.h"
+
+namespace CombatDuel
+{
+	/** Hurt state of ResolveHits */
+	const float HurtTime = 1.5f;
+	/** Part of a swing after which the blade reaches the opponent */
+	const float HitFraction = 0.4f;
+	/** Part of a swing after which the combo notify lets the attacker act again */
+	const float RecoverFraction = 0.6f;
+	const int32 NoStep = -1;
+
+	enum class EAction : uint8
+	{
+		Idle,
+		Attacking,
+		Dodging,
+		Defending,
+		Hurt
+	};
+
+	struct FFighterState
+	{
+		int32 Blood;
+		float Magic;
+		EAction Action = EAction::Idle;
+		int32 ActionEnd = NoStep;
+		int32 ComboNum = 0;
+		int32 ComboEnd = NoStep;
+		int32 HitStep = NoStep;
+		int32 ReactStep = NoStep;
+	};
+
+	int32 ToSteps(float Seconds, int32 StepRate)
+	{
+		return FMath::Max(FMath::CeilToInt(Seconds * StepRate), 1);
+	}
+}
+
+void FDuelFighter::InitFromClass(TSubclassOf<ACombatCharacter> Class)
+{
+	const ACombatCharacter* Defaults = Class ? Class->GetDefaultObject<ACombatCharacter>() : nullptr;
+	if (!Defaults)
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Duel: no class given, the fighter keeps all its default values"));
+		return;
+	}
+	const FString ClassName = Class->GetName();
+	FCombatStatsRegistry& Registry = FCombatStatsRegistry::Get();
+	Stats = Registry.GetBaseStats(Registry.FindStatsId(Defaults->StatsRow));
+	DodgeMagicCost = Defaults->DodgeMagicCost;
+	DefenceMagicCost = Defaults->DefenceMagicCost;
+
+	// Tools can afford to wait for the set the game streams in
+	const UCombatMontageSet* Montages = Defaults->Montages;
+	if (!Montages && !Defaults->StreamedMontages.IsNull())
+	{
+		Montages = Defaults->StreamedMontages.LoadSynchronous();
+	}
+	if (!Montages)
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Duel: %s has no montage set, swing, dodge and damage values are defaults"), *ClassName);
+		return;
+	}
+	const UAnimMontage* Swings[] = { Montages->Fast_One, Montages->Fast_Two, Montages->Fast_Three };
+	for (int32 Index = 0; Index < ARRAY_COUNT(Swings); ++Index)
+	{
+		if (Swings[Index])
+		{
+			SwingTimes[Index] = Swings[Index]->GetPlayLength();
+		}
+		else
+		{
+			UE_LOG(LogLyhCombat, Warning, TEXT("Duel: %s has no montage for swing %d, using %.2fs"), *ClassName, Index + 1, SwingTimes[Index]);
+		}
+	}
+	if (Montages->Dodge_Behind)
+	{
+		DodgeTime = FMath::Max(Montages->Dodge_Behind->GetPlayLength() - Defaults->DodgeRecoverTime, 0.f);
+	}
+	else
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Duel: %s has no dodge montage, using %.2fs"), *ClassName, DodgeTime);
+	}
+	if (const UHitReactionTable* HitReactions = Montages->HitReactions)
+	{
+		BaseDamage = HitReactions->BaseDamage;
+		// The head is the zone with the highest multiplier
+		HeadMultiplier = 1.f;
+		for (const FHitZone& Zone : HitReactions->Zones)
+		{
+			HeadMultiplier = FMath::Max(HeadMultiplier, Zone.DamageMultiplier);
+		}
+	}
+	else
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Duel: %s has no hit reaction table, using %d damage per hit"), *ClassName, BaseDamage);
+	}
+}
+
+FDuelResult FCombatDuelModel::Run(const FDuelFighter& Player, const FDuelFighter& Monster, int32 Seed, int32 StepRate, float MaxTime)
+{
+	using namespace CombatDuel;
+	const FDuelFighter* Fighters[2] = { &Player, &Monster };
+	FFighterState States[2];
+	for (int32 Side = 0; Side < 2; ++Side)
+	{
+		States[Side].Blood = Fighters[Side]->Stats.Blood;
+		States[Side].Magic = Fighters[Side]->Stats.Magic;
+	}
+	FRandomStream Random(Seed);
+	const float StepSeconds = 1.f / StepRate;
+	const int32 MaxSteps = FMath::CeilToInt(MaxTime * StepRate);
+
+	FDuelResult Result;
+	for (int32 Step = 0; Step < MaxSteps; ++Step)
+	{
+		// States that ran out, like AdvanceCombatState
+		for (FFighterState& State : States)
+		{
+			if (State.Action != EAction::Idle && Step >= State.ActionEnd)
+			{
+				State.Action = EAction::Idle;
+			}
+			if (State.ComboEnd != NoStep && Step >= State.ComboEnd)
+			{
+				State.ComboNum = 0;
+				State.ComboEnd = NoStep;
+			}
+		}
+
+		// Blades that arrive this step, like ResolveHits
+		for (int32 Side = 0; Side < 2; ++Side)
+		{
+			FFighterState& Attacker = States[Side];
+			if (Attacker.HitStep != Step)
+			{
+				continue;
+			}
+			Attacker.HitStep = NoStep;
+			const FDuelFighter& Target = *Fighters[1 - Side];
+			FFighterState& Victim = States[1 - Side];
+			if (Victim.Action == EAction::Dodging)
+			{
+				Result.Dodges[1 - Side]++;
+				continue;
+			}
+			if (Victim.Action == EAction::Defending)
+			{
+				Result.Blocks[1 - Side]++;
+				Victim.Action = EAction::Idle;
+				continue;
+			}
+			const float Multiplier = Random.FRand() < Target.HeadHitChance ? Target.HeadMultiplier : 1.f;
+			Victim.Blood -= FMath::RoundToInt(Target.BaseDamage * Multiplier);
+			Result.Hits[Side]++;
+			// A hit cancels the swing the victim was in
+			Victim.HitStep = NoStep;
+			Victim.Action = EAction::Hurt;
+			Victim.ActionEnd = Step + ToSteps(HurtTime, StepRate);
+			if (Victim.Blood <= 0)
+			{
+				Result.Outcome = Side == 0 ? EDuelOutcome::PlayerWon : EDuelOutcome::MonsterWon;
+				Result.Time = Step * StepSeconds;
+				return Result;
+			}
+		}
+
+		for (int32 Side = 0; Side < 2; ++Side)
+		{
+			const FDuelFighter& Fighter = *Fighters[Side];
+			FFighterState& State = States[Side];
+
+			// Reaction to the opponent's swing, like Dodge and Defence_Begin
+			if (State.ReactStep == Step)
+			{
+				State.ReactStep = NoStep;
+				const float Roll = Random.FRand();
+				if (Roll < Fighter.Policy.DodgeChance && State.Action != EAction::Dodging && State.Action != EAction::Defending && State.Magic >= Fighter.DodgeMagicCost)
+				{
+					State.Magic -= Fighter.DodgeMagicCost;
+					State.HitStep = NoStep;
+					State.ComboNum = 0;
+					State.ComboEnd = NoStep;
+					State.Action = EAction::Dodging;
+					State.ActionEnd = Step + ToSteps(Fighter.DodgeTime, StepRate);
+				}
+				else if (Roll < Fighter.Policy.DodgeChance + Fighter.Policy.DefenceChance && State.Action == EAction::Idle && State.Magic >= Fighter.DefenceMagicCost)
+				{
+					State.Magic -= Fighter.DefenceMagicCost;
+					State.Action = EAction::Defending;
+					State.ActionEnd = Step + ToSteps(Fighter.Policy.DefenceHoldTime, StepRate);
+				}
+			}
+
+			// Next swing of the combo, like AttackEnemy
+			if (State.Action == EAction::Idle && Random.FRand() < Fighter.Policy.AttackRate * StepSeconds)
+			{
+				const float SwingTime = Fighter.SwingTimes[State.ComboNum];
+				State.Action = EAction::Attacking;
+				State.ActionEnd = Step + ToSteps(SwingTime * RecoverFraction, StepRate);
+				State.HitStep = Step + ToSteps(SwingTime * HitFraction, StepRate);
+				State.ComboEnd = Step + ToSteps(SwingTime, StepRate);
+				State.ComboNum = (State.ComboNum + 1) % ARRAY_COUNT(Fighter.SwingTimes);
+				FFighterState& Opponent = States[1 - Side];
+				Opponent.ReactStep = Step + ToSteps(Fighters[1 - Side]->Policy.ReactionTime, StepRate);
+			}
+
+			// Like FCombatRegenSystem, up to the base magic
+			if (!(Fighter.bNoRegenWhileDefending && State.Action == EAction::Defending))
+			{
+				State.Magic = FMath::Min(State.Magic + Fighter.Stats.MagicRegain * StepSeconds, (float)Fighter.Stats.Magic);
+			}
+		}
+	}
+	Result.Time = MaxSteps * StepSeconds;
+	return Result;
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PlayerStats.h"
+
+class ACombatCharacter;
+
+/** How a simulated fighter decides, all chances are 0..1 */
+struct FDuelPolicy
+{
+	/** Chance per second to start an attack while free to act */
+	float AttackRate = 1.5f;
+	/** Reaction to an incoming swing: dodge with this chance, else defend with DefenceChance */
+	float DodgeChance = 0.f;
+	float DefenceChance = 0.f;
+	/** Seconds between the opponent starting a swing and the reaction */
+	float ReactionTime = 0.25f;
+	/** How long a defence is held when nothing hits it */
+	float DefenceHoldTime = 0.6f;
+};
+
+/** One side of a duel, the parts of ACombatCharacter and its montage set the fight depends on */
+struct LYHACTDEMO_API FDuelFighter
+{
+	FPlayerStats Stats;
+	int32 DodgeMagicCost = 0;
+	int32 DefenceMagicCost = 0;
+	/** Dodge montage length minus DodgeRecoverTime */
+	float DodgeTime = 0.3f;
+	/** Lengths of the three combo montages */
+	float SwingTimes[3] = { 0.9f, 0.9f, 1.2f };
+	/** The player stops regenerating magic while defending, see ALyhActDemoCharacter::OnDefenceBegin */
+	bool bNoRegenWhileDefending = false;
+	/** Damage taken per hit from the hit reaction table of this fighter */
+	int32 BaseDamage = 10;
+	float HeadMultiplier = 2.f;
+	float HeadHitChance = 0.2f;
+	FDuelPolicy Policy;
+
+	/** Fills the fighter from the class defaults of Class: costs, stats row and montage lengths. Loads
+	 *  StreamedMontages synchronously and warns about every value that keeps its default */
+	void InitFromClass(TSubclassOf<ACombatCharacter> Class);
+};
+
+enum class EDuelOutcome : uint8
+{
+	PlayerWon,
+	MonsterWon,
+	Timeout
+};
+
+struct FDuelResult
+{
+	EDuelOutcome Outcome = EDuelOutcome::Timeout;
+	/** Seconds until someone died, the time limit on a timeout */
+	float Time = 0.f;
+	/** Per side, index 0 is the player */
+	int32 Hits[2] = { 0, 0 };
+	int32 Dodges[2] = { 0, 0 };
+	int32 Blocks[2] = { 0, 0 };
+};
+
+/**
+ * The rules of AttackEnemy, Dodge, Defence_Begin and ResolveHits without actors, animation or a
+ * world: two fighters, integer steps and a random stream. A duel costs microseconds, so balance
+ * sweeps run thousands of them. The same seed always plays the same duel.
+ */
+class LYHACTDEMO_API FCombatDuelModel
+{
+public:
+	static FDuelResult Run(const FDuelFighter& Player, const FDuelFighter& Monster, int32 Seed, int32 StepRate, float MaxTime);
+};
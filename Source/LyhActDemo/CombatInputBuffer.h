@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatInputBuffer.generated.h"
+
+UENUM(BlueprintType)
+enum class ECombatInput : uint8
+{
+	Attack,
+	Dodge,
+	Defence,
+	Num UMETA(Hidden)
+};
+
+/**
+ * Last unconsumed press of every combat input with the world time it happened at. A press stays
+ * usable for a short while so it can be played at the next point the character is allowed to act.
+ */
+struct FCombatInputBuffer
+{
+	FCombatInputBuffer() { Clear(); }
+
+	void Press(ECombatInput Input, float Time) { PressTime[(int32)Input] = Time; }
+	void Consume(ECombatInput Input) { PressTime[(int32)Input] = -1.f; }
+
+	/** True if Input was pressed no longer than MaxAge before Now and not consumed since */
+	bool IsBuffered(ECombatInput Input, float Now, float MaxAge) const
+	{
+		const float Time = PressTime[(int32)Input];
+		return Time >= 0.f && Now - Time <= MaxAge;
+	}
+
+	/** Drops every press older than MaxAge, they can no longer be played */
+	void Expire(float Now, float MaxAge)
+	{
+		for (float& Time : PressTime)
+		{
+			if (Time >= 0.f && Now - Time > MaxAge)
+			{
+				Time = -1.f;
+			}
+		}
+	}
+
+	bool IsEmpty() const
+	{
+		for (float Time : PressTime)
+		{
+			if (Time >= 0.f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Clear()
+	{
+		for (float& Time : PressTime)
+		{
+			Time = -1.f;
+		}
+	}
+private:
+	float PressTime[(int32)ECombatInput::Num];
+};
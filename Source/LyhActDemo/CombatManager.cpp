@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatManager.h"
+#include "CombatCharacter.h"
+#include "AICharacter.h"
+#include "CombatProfiling.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/Pawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Combat Manager Tick"), STAT_LyhCombat_ManagerTick, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Resolve Damage"), STAT_LyhCombat_ResolveDamage, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Advance States"), STAT_LyhCombat_AdvanceStates, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Attack Tokens"), STAT_LyhCombat_AttackTokens, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Regen"), STAT_LyhCombat_Regen, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Rebuild Target Grid"), STAT_LyhCombat_RebuildGrid, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Schedule Perception"), STAT_LyhCombat_SchedulePerception, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Net Tiers"), STAT_LyhCombat_NetTiers, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Anim Budget"), STAT_LyhCombat_AnimBudget, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Movement LOD"), STAT_LyhCombat_MovementLod, STATGROUP_LyhCombat);
+DECLARE_CYCLE_STAT(TEXT("Crowd"), STAT_LyhCombat_Crowd, STATGROUP_LyhCombat);
+
+namespace CombatFixedStep
+{
+	/** A long hitch is not caught up in one frame, the combat clock falls behind instead */
+	const int32 MaxStepsPerFrame = 8;
+}
+
+namespace
+{
+	/** Live managers, one per game world; only PIE has more than one */
+	TArray<TWeakObjectPtr<ACombatManager>> GCombatManagers;
+}
+
+ACombatManager::ACombatManager()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	// Hits are reported while actors tick and physics runs, resolve them once everything is done
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+	bReplicates = false;
+	TargetGridCellSize = 1000.f;
+	PerceptionBudgetUs = 500.f;
+	NetNearDistance = 2500.f;
+	AnimUpdatesPerFrame = 60;
+	AnimFullRateDistance = 1500.f;
+	LodMovementDistance = 5000.f;
+	CrowdAgentBudget = 40;
+	SurroundSlots = 8;
+	SurroundRadius = 150.f;
+	AttackTokensPerTarget = 2;
+	AttackTokenLease = 5.f;
+	AttackTokenRange = 400.f;
+	bFixedStepCombat = false;
+	FixedStepRate = 30;
+	CombatRandomSeed = 0;
+}
+
+ACombatManager* ACombatManager::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (!World || !World->IsGameWorld() || World->bIsTearingDown)
+	{
+		return nullptr;
+	}
+	for (const TWeakObjectPtr<ACombatManager>& Manager : GCombatManagers)
+	{
+		if (Manager.IsValid() && Manager->GetWorld() == World)
+		{
+			return Manager.Get();
+		}
+	}
+
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnInfo.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<ACombatManager>(SpawnInfo);
+}
+
+void ACombatManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+	GCombatManagers.RemoveAll([](const TWeakObjectPtr<ACombatManager>& Manager) { return !Manager.IsValid(); });
+	GCombatManagers.Add(this);
+	TargetGrid.SetCellSize(TargetGridCellSize);
+	PerceptionScheduler.SetBudget(PerceptionBudgetUs);
+	NetTiers.SetNearDistance(NetNearDistance);
+	AnimBudget.SetBudget(AnimUpdatesPerFrame, AnimFullRateDistance);
+	MovementLod.SetDistance(LodMovementDistance);
+	Crowd.SetAgentBudget(CrowdAgentBudget);
+	Crowd.SetSlots(SurroundSlots, SurroundRadius);
+	AttackTokens.SetTokens(AttackTokensPerTarget, AttackTokenLease);
+	SetFixedStep(bFixedStepCombat, FixedStepRate, CombatRandomSeed);
+}
+
+void ACombatManager::SetFixedStep(bool bEnable, int32 StepRate, int32 Seed)
+{
+	// The step clock starts where the world clock is, so running timers stay valid
+	const float Now = GetCombatTime();
+	bFixedStepCombat = bEnable;
+	FixedStepRate = FMath::Max(StepRate, 1);
+	CombatRandomSeed = Seed;
+	StepSeconds = 1.f / FixedStepRate;
+	CombatStep = (uint32)FMath::CeilToInt(Now * FixedStepRate);
+	StepRemainder = 0.f;
+	Random.Initialize(Seed);
+}
+
+void ACombatManager::SimulateSteps(int32 NumSteps)
+{
+	if (!bFixedStepCombat)
+	{
+		return;
+	}
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		StepCombat(StepSeconds);
+	}
+}
+
+float ACombatManager::GetCombatTime() const
+{
+	if (bFixedStepCombat)
+	{
+		return (float)((double)CombatStep / FixedStepRate);
+	}
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.f;
+}
+
+float ACombatManager::GetCombatTimeAfter(float Duration) const
+{
+	if (bFixedStepCombat)
+	{
+		// Same division as GetCombatTime, so the end time compares equal on the step it falls on
+		const uint32 EndStep = CombatStep + (uint32)FMath::Max(FMath::CeilToInt(Duration * FixedStepRate), 1);
+		return (float)((double)EndStep / FixedStepRate);
+	}
+	return GetCombatTime() + Duration;
+}
+
+bool ACombatManager::StartReplayRecording(const FString& Filename)
+{
+	// A replay stamps events with combat steps, which only mean the same time in fixed step mode,
+	// and the playback starts the random stream from the seed as well
+	SetFixedStep(true, FixedStepRate, CombatRandomSeed);
+	Replay.SetStep(CombatStep);
+	return Replay.Start(Filename, FixedStepRate, CombatRandomSeed);
+}
+
+void ACombatManager::StopReplayRecording()
+{
+	Replay.Stop();
+}
+
+void ACombatManager::ApplyReplayHit(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint)
+{
+	if (Victim)
+	{
+		TGuardValue<bool> ApplyingReplayHit(bApplyingReplayHit, true);
+		Victim->OnAttackedBy(AttackPoint, Attacker);
+	}
+}
+
+float ACombatManager::CombatRandRange(UObject* WorldContextObject, float Min, float Max)
+{
+	ACombatManager* Manager = Get(WorldContextObject);
+	return Manager ? Manager->Random.FRandRange(Min, Max) : FMath::FRandRange(Min, Max);
+}
+
+void ACombatManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+	GCombatManagers.Remove(this);
+	DamageQueue.Reset();
+	MonsterPool.Reset();
+	Replay.Stop();
+}
+
+void ACombatManager::RegisterCombatant(ACombatCharacter* Character)
+{
+	// Pooled monsters coming back keep their index
+	if (Character->CombatantIndex == 0)
+	{
+		Character->CombatantIndex = NextCombatantIndex++;
+	}
+	TargetGrid.Register(Character);
+	Combatants.AddUnique(Character);
+	// Clients get magic from the replicated combat state
+	if (Character->Role == ROLE_Authority && Character->GetBaseStats().Magic > 0)
+	{
+		RegenSystem.Register(Character);
+	}
+	// Only a server with connections replicates, standalone games skip the tiers
+	AAICharacter* Monster = Cast<AAICharacter>(Character);
+	const ENetMode NetMode = GetNetMode();
+	if (Monster && (NetMode == NM_DedicatedServer || NetMode == NM_ListenServer))
+	{
+		NetTiers.Register(Monster);
+	}
+	if (Monster)
+	{
+		AnimBudget.Register(Monster);
+		// Clients only see the replicated movement of the monsters
+		if (Monster->Role == ROLE_Authority)
+		{
+			MovementLod.Register(Monster);
+		}
+	}
+}
+
+void ACombatManager::UnregisterCombatant(ACombatCharacter* Character)
+{
+	TargetGrid.Unregister(Character);
+	Combatants.RemoveSwap(Character);
+	RegenSystem.Unregister(Character);
+	AttackTokens.Release(Character);
+	if (AAICharacter* Monster = Cast<AAICharacter>(Character))
+	{
+		NetTiers.Unregister(Monster);
+		AnimBudget.Unregister(Monster);
+		MovementLod.Unregister(Monster);
+	}
+}
+
+void ACombatManager::StepCombat(float DeltaSeconds)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_ResolveDamage);
+		DamageQueue.Resolve();
+	}
+
+	// Runs out combo, dodge and hurt states of everyone in one pass instead of a timer per state
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_AdvanceStates);
+		const float Now = GetCombatTime();
+		for (int32 Index = Combatants.Num() - 1; Index >= 0; --Index)
+		{
+			if (ACombatCharacter* Combatant = Combatants[Index].Get())
+			{
+				Combatant->AdvanceCombatState(Now);
+			}
+			else
+			{
+				Combatants.RemoveAtSwap(Index, 1, false);
+			}
+		}
+	}
+	// Tokens given back by the combos that just ended go to the waiting monsters right away
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_AttackTokens);
+		AttackTokens.Update(GetCombatTime());
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_Regen);
+		RegenSystem.Update(DeltaSeconds);
+	}
+	CombatStep++;
+	Replay.SetStep(CombatStep);
+}
+
+void ACombatManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyhCombat_ManagerTick);
+	Super::Tick(DeltaSeconds);
+	if (bFixedStepCombat)
+	{
+		StepRemainder += DeltaSeconds;
+		// A frame of exactly one step must not come out a hair short of it
+		int32 NumSteps = FMath::FloorToInt(StepRemainder * FixedStepRate + KINDA_SMALL_NUMBER);
+		StepRemainder -= NumSteps * StepSeconds;
+		if (NumSteps > CombatFixedStep::MaxStepsPerFrame)
+		{
+			NumSteps = CombatFixedStep::MaxStepsPerFrame;
+			StepRemainder = 0.f;
+		}
+		SimulateSteps(NumSteps);
+	}
+	else
+	{
+		StepCombat(DeltaSeconds);
+	}
+	if (Replay.IsRecording())
+	{
+		Replay.RecordLocations(Combatants);
+	}
+
+	// Perception queries of the next frame see where everyone ended up this frame
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_RebuildGrid);
+		TargetGrid.Rebuild();
+	}
+
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* Pawn = It->IsValid() ? (*It)->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_SchedulePerception);
+		PerceptionScheduler.Update(DeltaSeconds, PlayerLocations);
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_NetTiers);
+		NetTiers.Update(DeltaSeconds, PlayerLocations);
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_AnimBudget);
+		AnimBudget.Update(DeltaSeconds, PlayerLocations);
+	}
+	{
+		SCOPE_CYCLE_COUNTER(STAT_LyhCombat_MovementLod);
+		MovementLod.Update(GetWorld(), DeltaSeconds, PlayerLocations);
+	}
+	SCOPE_CYCLE_COUNTER(STAT_LyhCombat_Crowd);
+	Crowd.Update(DeltaSeconds, PlayerLocations);
+}
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "CombatDamageQueue.h"
+#include "CombatTargetGrid.h"
+#include "PerceptionScheduler.h"
+#include "CombatRegenSystem.h"
+#include "MonsterPool.h"
+#include "CombatNetTiers.h"
+#include "CombatAnimBudget.h"
+#include "CombatMovementLod.h"
+#include "CombatCrowd.h"
+#include "CombatAttackTokens.h"
+#include "CombatReplay.h"
+#include "CombatManager.generated.h"
+
+/**
+ * One per game world, spawned on first use. Owns the batched combat systems and runs them
+ * once per frame after everything else has ticked.
+ */
+UCLASS(config = Game, notplaceable, transient)
+class LYHACTDEMO_API ACombatManager : public AInfo
+{
+	GENERATED_BODY()
+public:
+	ACombatManager();
+
+	/** Returns the manager of the world WorldContextObject lives in, spawning it if needed. Null outside game worlds */
+	static ACombatManager* Get(const UObject* WorldContextObject);
+
+	/** Adds Character to the target grid, the batched state update and, if it has magic, to regeneration */
+	void RegisterCombatant(ACombatCharacter* Character);
+	void UnregisterCombatant(ACombatCharacter* Character);
+
+	FCombatDamageQueue& GetDamageQueue() { return DamageQueue; }
+	FCombatTargetGrid& GetTargetGrid() { return TargetGrid; }
+	FPerceptionScheduler& GetPerceptionScheduler() { return PerceptionScheduler; }
+	FCombatRegenSystem& GetRegenSystem() { return RegenSystem; }
+	FMonsterPool& GetMonsterPool() { return MonsterPool; }
+	FCombatNetTiers& GetNetTiers() { return NetTiers; }
+	FCombatAnimBudget& GetAnimBudget() { return AnimBudget; }
+	FCombatMovementLod& GetMovementLod() { return MovementLod; }
+	FCombatCrowd& GetCrowd() { return Crowd; }
+	FCombatAttackTokens& GetAttackTokens() { return AttackTokens; }
+
+	/**
+	 * Switches the combat states, damage, regeneration and attack tokens to whole steps of
+	 * 1 / StepRate seconds and reseeds the combat random stream. Same seed and inputs replay the
+	 * same fight on any machine, whatever the frame rate
+	 */
+	void SetFixedStep(bool bEnable, int32 StepRate, int32 Seed);
+	bool IsFixedStep() const { return bFixedStepCombat; }
+	/** Runs NumSteps combat steps right away, for simulations faster than real time. Fixed step only */
+	void SimulateSteps(int32 NumSteps);
+
+	/** Clock of the combat states: whole steps in fixed step mode, the world time otherwise */
+	float GetCombatTime() const;
+	/** Combat time Duration from now, rounded up to a whole step in fixed step mode */
+	float GetCombatTimeAfter(float Duration) const;
+	uint32 GetCombatStep() const { return CombatStep; }
+	FRandomStream& GetRandom() { return Random; }
+
+	/** Streams the fight to Filename until StopReplayRecording, switching to fixed step if needed */
+	bool StartReplayRecording(const FString& Filename);
+	void StopReplayRecording();
+	/** The recorder while a replay is being recorded, null otherwise */
+	FCombatReplayRecorder* GetReplayRecorder() { return Replay.IsRecording() ? &Replay : nullptr; }
+
+	/** While a replay plays back only its recorded hits count, live weapons would deal them a second time */
+	void SetReplayPlayback(bool bEnable) { bReplayPlayback = bEnable; }
+	/** Applies a hit read from a replay */
+	void ApplyReplayHit(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint);
+	/** False for hits of weapons and traces during replay playback */
+	bool AcceptsHit() const { return !bReplayPlayback || bApplyingReplayHit; }
+
+	/** Draws from the combat random stream, so Blueprint randomness is reproducible in fixed step mode */
+	UFUNCTION(BlueprintCallable, Category = "Combat", meta = (WorldContext = "WorldContextObject"))
+	static float CombatRandRange(UObject* WorldContextObject, float Min, float Max);
+
+	/** Cell size of the target grid, about the usual perception radius */
+	UPROPERTY(config)
+	float TargetGridCellSize;
+
+	/** Game thread time all monster enemy checks may take per frame, in microseconds */
+	UPROPERTY(config)
+	float PerceptionBudgetUs;
+
+	/** Monsters closer than this to a player replicate at the near or combat rate */
+	UPROPERTY(config)
+	float NetNearDistance;
+
+	/** Monster meshes that may update their animation per frame, fighting monsters near a player not counted */
+	UPROPERTY(config)
+	int32 AnimUpdatesPerFrame;
+
+	/** Monsters closer than this to a player always update their animation every frame */
+	UPROPERTY(config)
+	float AnimFullRateDistance;
+
+	/** Monsters farther than this from every player switch to the simplified movement */
+	UPROPERTY(config)
+	float LodMovementDistance;
+
+	/** Monsters running full crowd avoidance at once, keep below MaxAgents of the crowd manager */
+	UPROPERTY(config)
+	int32 CrowdAgentBudget;
+
+	/** Slots around a target monsters spread over, and their distance from it */
+	UPROPERTY(config)
+	int32 SurroundSlots;
+	UPROPERTY(config)
+	float SurroundRadius;
+
+	/** Monsters that may attack one player at the same time */
+	UPROPERTY(config)
+	int32 AttackTokensPerTarget;
+
+	/** Seconds after which a token that was never given back returns to its target */
+	UPROPERTY(config)
+	float AttackTokenLease;
+
+	/** Monsters ask the closest player within this distance for a token before attacking */
+	UPROPERTY(config)
+	float AttackTokenRange;
+
+	/** Advances combat in fixed steps of 1 / FixedStepRate seconds, see SetFixedStep */
+	UPROPERTY(config)
+	bool bFixedStepCombat;
+	UPROPERTY(config)
+	int32 FixedStepRate;
+	UPROPERTY(config)
+	int32 CombatRandomSeed;
+
+	virtual void Tick(float DeltaSeconds) override;
+protected:
+	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+private:
+	/** Damage, state timers, attack tokens and regeneration for DeltaSeconds */
+	void StepCombat(float DeltaSeconds);
+
+	FCombatDamageQueue DamageQueue;
+	FCombatTargetGrid TargetGrid;
+	FPerceptionScheduler PerceptionScheduler;
+	FCombatRegenSystem RegenSystem;
+	FMonsterPool MonsterPool;
+	FCombatNetTiers NetTiers;
+	FCombatAnimBudget AnimBudget;
+	FCombatMovementLod MovementLod;
+	FCombatCrowd Crowd;
+	FCombatAttackTokens AttackTokens;
+	FCombatReplayRecorder Replay;
+	TArray<FVector> PlayerLocations;
+	TArray<TWeakObjectPtr<ACombatCharacter>> Combatants;
+	FRandomStream Random;
+	uint32 NextCombatantIndex = 1;
+	bool bReplayPlayback = false;
+	bool bApplyingReplayHit = false;
+	uint32 CombatStep = 0;
+	float StepSeconds = 1.f / 30.f;
+	/** Frame time not yet covered by a whole step */
+	float StepRemainder = 0.f;
+};
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatMontageSet.h"
+#include "HitReactionTable.h"
+
+namespace CombatMontageSet
+{
+	/** Ids 1 .. NumFixed are the montages with their own property, Hit_Torso_Front is id 4 */
+	const uint8 NumFixed = 9;
+	const uint8 HitTorsoFrontId = 4;
+
+	FStreamableManager& GetStreamableManager()
+	{
+		static FStreamableManager StreamableManager;
+		return StreamableManager;
+	}
+}
+
+void UCombatMontageSet::PostLoad()
+{
+	Super::PostLoad();
+	BuildMontageIds();
+}
+
+#if WITH_EDITOR
+void UCombatMontageSet::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BuildMontageIds();
+}
+#endif
+
+TSharedPtr<FStreamableHandle> UCombatMontageSet::Preload(const TSoftObjectPtr<UCombatMontageSet>& Set, TAsyncLoadPriority Priority, FStreamableDelegate OnLoaded)
+{
+	if (Set.IsNull() || Set.Get())
+	{
+		OnLoaded.ExecuteIfBound();
+		return nullptr;
+	}
+	// The montages are hard references of the set and arrive in the same request
+	return CombatMontageSet::GetStreamableManager().RequestAsyncLoad(Set.ToSoftObjectPath(), OnLoaded, Priority);
+}
+
+void UCombatMontageSet::BuildMontageIds() const
+{
+	// Server and clients load the same asset, so the order below is the same on both ends
+	UAnimMontage* const Fixed[] = { Fast_One, Fast_Two, Fast_Three, Hit_Torso_Front, Dodge_Left, Dodge_Right, Dodge_Behind, Defence_Start, Defence_Succeed };
+	static_assert(ARRAY_COUNT(Fixed) == CombatMontageSet::NumFixed, "Fixed montages changed, update NumFixed");
+	MontagesById.Reset();
+	MontagesById.Append(Fixed, ARRAY_COUNT(Fixed));
+	if (HitReactions)
+	{
+		for (const FHitZone& Zone : HitReactions->Zones)
+		{
+			MontagesById.Add(Zone.Back);
+			MontagesById.Add(Zone.FrontLeft);
+			MontagesById.Add(Zone.FrontCenter);
+			MontagesById.Add(Zone.FrontRight);
+		}
+	}
+	ensureMsgf(MontagesById.Num() <= MAX_uint8, TEXT("%s has more montages than a montage id can address"), *GetName());
+}
+
+uint8 UCombatMontageSet::GetMontageId(const UAnimMontage* Montage) const
+{
+	if (!Montage)
+	{
+		return 0;
+	}
+	if (MontagesById.Num() == 0)
+	{
+		BuildMontageIds();
+	}
+	const int32 Index = MontagesById.IndexOfByKey(Montage);
+	return Index != INDEX_NONE && Index < MAX_uint8 ? uint8(Index + 1) : 0;
+}
+
+UAnimMontage* UCombatMontageSet::GetMontageById(uint8 Id) const
+{
+	if (MontagesById.Num() == 0)
+	{
+		BuildMontageIds();
+	}
+	return Id > 0 && MontagesById.IsValidIndex(Id - 1) ? MontagesById[Id - 1] : nullptr;
+}
+
+bool UCombatMontageSet::IsHitReactionId(uint8 Id) const
+{
+	return Id == CombatMontageSet::HitTorsoFrontId || Id > CombatMontageSet::NumFixed;
+}
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Engine/StreamableManager.h"
+#include "CombatMontageSet.generated.h"
+
+class UAnimMontage;
+class UHitReactionTable;
+
+/**
+ * Combat montages of one skeleton. A single asset is referenced by the defaults of a character class,
+ * so every instance of that class shares the same read-only table instead of carrying its own copy.
+ * Classes that reference it softly stream it in with Preload instead of loading it with the class.
+ */
+UCLASS(BlueprintType)
+class LYHACTDEMO_API UCombatMontageSet : public UDataAsset
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attack")
+	UAnimMontage* Fast_One;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attack")
+	UAnimMontage* Fast_Two;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Attack")
+	UAnimMontage* Fast_Three;
+	/** Reaction when an attack is bounced off a defending enemy */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit")
+	UAnimMontage* Hit_Torso_Front;
+	/** Zone table that picks hit reactions and damage */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit")
+	UHitReactionTable* HitReactions;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Dodge")
+	UAnimMontage* Dodge_Left;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Dodge")
+	UAnimMontage* Dodge_Right;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Dodge")
+	UAnimMontage* Dodge_Behind;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Defence")
+	UAnimMontage* Defence_Start;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Defence")
+	UAnimMontage* Defence_Succeed;
+
+	/** Small id of Montage sent over the network instead of the object, 0 if it is not part of the set */
+	uint8 GetMontageId(const UAnimMontage* Montage) const;
+	UAnimMontage* GetMontageById(uint8 Id) const;
+	/** True for the ids of Hit_Torso_Front and the hit reaction table */
+	bool IsHitReactionId(uint8 Id) const;
+
+	/**
+	 * Streams Set and every montage it references in the background, ahead of anything loaded with a
+	 * lower Priority. OnLoaded runs on the game thread once everything is in, right away if it already is
+	 */
+	static TSharedPtr<FStreamableHandle> Preload(const TSoftObjectPtr<UCombatMontageSet>& Set, TAsyncLoadPriority Priority, FStreamableDelegate OnLoaded = FStreamableDelegate());
+
+	/** Builds the id table on load, so the first hit of a fight does not pay for it */
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	/** Ids follow the montages and the hit reaction table, e.g. when another table is assigned */
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+private:
+	/** Every montage of the set and its hit reactions in a fixed order, id - 1 indexes it */
+	void BuildMontageIds() const;
+	mutable TArray<UAnimMontage*> MontagesById;
+};
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatMovementLod.h"
+#include "AICharacter.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "AI/Navigation/NavigationSystem.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+
+namespace CombatMovementLod
+{
+	/** Seconds between two distance checks */
+	const float LodInterval = 0.5f;
+	/** Monsters switch back a bit closer than they switched out so they do not flicker on the border */
+	const float Hysteresis = 500.f;
+	/** Each monster is snapped to the navmesh every this many frames */
+	const uint32 ProjectEveryFrames = 8;
+	/** Vertical reach of the navmesh projection */
+	const FVector ProjectExtent(50.f, 50.f, 250.f);
+}
+
+void FCombatMovementLod::Register(AAICharacter* Monster)
+{
+	if (!Monster || Entries.ContainsByPredicate([Monster](const FEntry& Entry) { return Entry.Monster == Monster; }))
+	{
+		return;
+	}
+	FEntry Entry;
+	Entry.Monster = Monster;
+	Entry.bSimplified = false;
+	Entries.Add(Entry);
+}
+
+void FCombatMovementLod::Unregister(AAICharacter* Monster)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Monster](const FEntry& Entry) { return Entry.Monster == Monster; });
+	if (Index != INDEX_NONE)
+	{
+		SetSimplified(Entries[Index], false);
+		Entries.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+int32 FCombatMovementLod::NumSimplified() const
+{
+	int32 Count = 0;
+	for (const FEntry& Entry : Entries)
+	{
+		Count += Entry.bSimplified ? 1 : 0;
+	}
+	return Count;
+}
+
+void FCombatMovementLod::SetSimplified(FEntry& Entry, bool bSimplified)
+{
+	AAICharacter* Monster = Entry.Monster.Get();
+	if (!Monster || Entry.bSimplified == bSimplified)
+	{
+		Entry.bSimplified = bSimplified;
+		return;
+	}
+	Entry.bSimplified = bSimplified;
+	UCharacterMovementComponent* Movement = Monster->GetCharacterMovement();
+	Movement->SetComponentTickEnabled(!bSimplified);
+	if (!bSimplified)
+	{
+		// Let character movement find the floor under wherever the simple update left it
+		Movement->SetMovementMode(MOVE_Walking);
+	}
+}
+
+void FCombatMovementLod::UpdateLods(const TArray<FVector>& PlayerLocations)
+{
+	const float OutSquared = FMath::Square(LodDistance);
+	const float InSquared = FMath::Square(FMath::Max(LodDistance - CombatMovementLod::Hysteresis, 0.f));
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		FEntry& Entry = Entries[Index];
+		const AAICharacter* Monster = Entry.Monster.Get();
+		if (!Monster)
+		{
+			Entries.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+		const FVector Location = Monster->GetActorLocation();
+		float ClosestSquared = BIG_NUMBER;
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			ClosestSquared = FMath::Min(ClosestSquared, FVector::DistSquared(Location, PlayerLocation));
+		}
+		const bool bFighting = Monster->bIsAttacking || Monster->bIsAttacked || Monster->bIsDodging || Monster->bIsDefencing;
+		const bool bFalling = Monster->GetCharacterMovement()->IsFalling();
+		if (bFighting || ClosestSquared < InSquared || PlayerLocations.Num() == 0)
+		{
+			SetSimplified(Entry, false);
+		}
+		else if (ClosestSquared > OutSquared && !bFalling)
+		{
+			SetSimplified(Entry, true);
+		}
+	}
+}
+
+void FCombatMovementLod::MoveSimplified(UWorld* World, float DeltaSeconds)
+{
+	UNavigationSystem* NavSys = UNavigationSystem::GetCurrent<UNavigationSystem>(World);
+	ProjectCursor++;
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		FEntry& Entry = Entries[Index];
+		AAICharacter* Monster = Entry.bSimplified ? Entry.Monster.Get() : nullptr;
+		const AAIController* Controller = Monster ? Cast<AAIController>(Monster->GetController()) : nullptr;
+		const UPathFollowingComponent* PathFollowing = Controller ? Controller->GetPathFollowingComponent() : nullptr;
+		if (!PathFollowing)
+		{
+			continue;
+		}
+		UCharacterMovementComponent* Movement = Monster->GetCharacterMovement();
+		if (PathFollowing->GetStatus() != EPathFollowingStatus::Moving)
+		{
+			Movement->Velocity = FVector::ZeroVector;
+			continue;
+		}
+
+		const FVector Direction = PathFollowing->GetCurrentDirection();
+		FVector Location = Monster->GetActorLocation() + Direction * Movement->MaxWalkSpeed * DeltaSeconds;
+		// Staggered so only a slice of the monsters queries the navmesh in any frame
+		if (NavSys && (ProjectCursor + Index) % CombatMovementLod::ProjectEveryFrames == 0)
+		{
+			const float HalfHeight = Monster->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+			FNavLocation OnNavMesh;
+			if (NavSys->ProjectPointToNavigation(Location - FVector(0.f, 0.f, HalfHeight), OnNavMesh, CombatMovementLod::ProjectExtent))
+			{
+				Location = OnNavMesh.Location + FVector(0.f, 0.f, HalfHeight);
+			}
+		}
+		FRotator Rotation = Monster->GetActorRotation();
+		if (!Direction.IsNearlyZero())
+		{
+			Rotation.Yaw = Direction.Rotation().Yaw;
+		}
+		Monster->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::None);
+		// The animation blueprint reads the speed from here
+		Movement->Velocity = Direction * Movement->MaxWalkSpeed;
+	}
+}
+
+void FCombatMovementLod::Update(UWorld* World, float DeltaSeconds, const TArray<FVector>& PlayerLocations)
+{
+	TimeToUpdateLods -= DeltaSeconds;
+	if (TimeToUpdateLods <= 0.f)
+	{
+		TimeToUpdateLods = CombatMovementLod::LodInterval;
+		UpdateLods(PlayerLocations);
+	}
+	MoveSimplified(World, DeltaSeconds);
+}
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AAICharacter;
+
+/**
+ * Cheap movement for monsters far from every player. Their character movement stops ticking and
+ * all of them are moved in one loop along the direction their path following asks for, at walking
+ * speed and without sweeping; every few frames each one is snapped back onto the navmesh. Character
+ * movement takes over again once a player comes close or the monster starts fighting.
+ */
+class LYHACTDEMO_API FCombatMovementLod
+{
+public:
+	void SetDistance(float InLodDistance) { LodDistance = InLodDistance; }
+	void Register(AAICharacter* Monster);
+	void Unregister(AAICharacter* Monster);
+	int32 NumSimplified() const;
+
+	void Update(UWorld* World, float DeltaSeconds, const TArray<FVector>& PlayerLocations);
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<AAICharacter> Monster;
+		bool bSimplified;
+	};
+
+	void SetSimplified(FEntry& Entry, bool bSimplified);
+	void UpdateLods(const TArray<FVector>& PlayerLocations);
+	void MoveSimplified(UWorld* World, float DeltaSeconds);
+
+	TArray<FEntry> Entries;
+	float LodDistance = 5000.f;
+	float TimeToUpdateLods = 0.f;
+	/** Advances every frame, picks the monsters that are projected onto the navmesh */
+	uint32 ProjectCursor = 0;
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatNetTiers.h"
+#include "AICharacter.h"
+
+namespace CombatNetTiers
+{
+	/** Seconds between two passes over the monsters */
+	const float UpdateInterval = 0.2f;
+	/** Net update frequency and priority of each tier but Dormant */
+	const float Frequency[] = { 0.f, 2.f, 10.f, 30.f };
+	const float Priority[] = { 0.f, 1.f, 2.f, 3.f };
+}
+
+void FCombatNetTiers::Register(AAICharacter* Monster)
+{
+	if (!Monster || Monsters.Contains(Monster))
+	{
+		return;
+	}
+	Monsters.Add(Monster);
+	Tiers.Add(ECombatNetTier::Unset);
+}
+
+void FCombatNetTiers::Unregister(AAICharacter* Monster)
+{
+	const int32 Index = Monsters.IndexOfByKey(Monster);
+	if (Index != INDEX_NONE)
+	{
+		Monsters.RemoveAtSwap(Index, 1, false);
+		Tiers.RemoveAtSwap(Index, 1, false);
+	}
+}
+
+ECombatNetTier FCombatNetTiers::PickTier(const AAICharacter& Monster, const TArray<FVector>& PlayerLocations) const
+{
+	const FVector Location = Monster.GetActorLocation();
+	float ClosestSquared = BIG_NUMBER;
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		ClosestSquared = FMath::Min(ClosestSquared, FVector::DistSquared(Location, PlayerLocation));
+	}
+	const bool bFighting = Monster.bIsAttacking || Monster.bIsAttacked || Monster.bIsDodging || Monster.bIsDefencing;
+	if (ClosestSquared <= FMath::Square(NearDistance))
+	{
+		return bFighting ? ECombatNetTier::Combat : ECombatNetTier::Near;
+	}
+	// A monster fighting far away still has to tell the clients how that ends
+	if (bFighting || ClosestSquared <= Monster.NetCullDistanceSquared)
+	{
+		return ECombatNetTier::Far;
+	}
+	return ECombatNetTier::Dormant;
+}
+
+void FCombatNetTiers::ApplyTier(AAICharacter& Monster, ECombatNetTier Tier)
+{
+	if (Tier == ECombatNetTier::Dormant)
+	{
+		Monster.SetNetDormancy(DORM_DormantAll);
+		return;
+	}
+	if (Monster.NetDormancy != DORM_Awake)
+	{
+		Monster.SetNetDormancy(DORM_Awake);
+	}
+	Monster.NetUpdateFrequency = CombatNetTiers::Frequency[(int32)Tier];
+	Monster.NetPriority = CombatNetTiers::Priority[(int32)Tier];
+	Monster.ForceNetUpdate();
+}
+
+void FCombatNetTiers::Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations)
+{
+	TimeToUpdate -= DeltaSeconds;
+	if (TimeToUpdate > 0.f)
+	{
+		return;
+	}
+	TimeToUpdate += CombatNetTiers::UpdateInterval;
+	if (TimeToUpdate < 0.f)
+	{
+		TimeToUpdate = CombatNetTiers::UpdateInterval;
+	}
+
+	for (int32 Index = Monsters.Num() - 1; Index >= 0; --Index)
+	{
+		AAICharacter* Monster = Monsters[Index].Get();
+		if (!Monster)
+		{
+			Monsters.RemoveAtSwap(Index, 1, false);
+			Tiers.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+		const ECombatNetTier Tier = PickTier(*Monster, PlayerLocations);
+		if (Tier != Tiers[Index])
+		{
+			Tiers[Index] = Tier;
+			ApplyTier(*Monster, Tier);
+		}
+	}
+}
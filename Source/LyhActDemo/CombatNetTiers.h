@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AAICharacter;
+
+/** How often a monster is considered for replication */
+enum class ECombatNetTier : uint8
+{
+	/** Out of every player's cull distance and not fighting, skipped by the net driver */
+	Dormant,
+	Far,
+	Near,
+	/** Fighting close to a player */
+	Combat,
+	Unset,
+};
+
+/**
+ * Server side replication tiers of the monsters. A few times a second every monster is put in a tier
+ * by the distance to the closest player and its combat state; the tier sets its net update frequency
+ * and priority, and monsters no player can see go dormant so the net driver stops considering them.
+ * Pooled monsters go dormant on their own when they are deactivated.
+ */
+class LYHACTDEMO_API FCombatNetTiers
+{
+public:
+	void SetNearDistance(float InNearDistance) { NearDistance = InNearDistance; }
+	void Register(AAICharacter* Monster);
+	void Unregister(AAICharacter* Monster);
+	int32 Num() const { return Monsters.Num(); }
+
+	void Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations);
+private:
+	ECombatNetTier PickTier(const AAICharacter& Monster, const TArray<FVector>& PlayerLocations) const;
+	static void ApplyTier(AAICharacter& Monster, ECombatNetTier Tier);
+
+	TArray<TWeakObjectPtr<AAICharacter>> Monsters;
+	TArray<ECombatNetTier> Tiers;
+	float NearDistance = 2500.f;
+	float TimeToUpdate = 0.f;
+};
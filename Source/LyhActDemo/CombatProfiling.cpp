@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatProfiling.h"
+
+DEFINE_STAT(STAT_LyhCombat_AttackEnemy);
+DEFINE_STAT(STAT_LyhCombat_Dodge);
+DEFINE_STAT(STAT_LyhCombat_OnAttacked);
+DEFINE_STAT(STAT_LyhCombat_ResolveHits);
+DEFINE_STAT(STAT_LyhCombat_CheckEnemy);
+DEFINE_STAT(STAT_LyhCombat_CheckAI);
+DEFINE_STAT(STAT_LyhCombat_WeaponTrace);
+DEFINE_STAT(STAT_LyhCombat_Hits);
+DEFINE_STAT(STAT_LyhCombat_Traces);
+DEFINE_STAT(STAT_LyhCombat_LockOnTraces);
+DEFINE_STAT(STAT_LyhCombat_StateTimers);
+
+FCombatCounters GCombatCounters;
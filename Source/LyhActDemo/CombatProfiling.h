@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** Game module side of the frame, view with "stat LyhCombat" */
+DECLARE_STATS_GROUP(TEXT("LyhCombat"), STATGROUP_LyhCombat, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("AttackEnemy"), STAT_LyhCombat_AttackEnemy, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Dodge"), STAT_LyhCombat_Dodge, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnAttacked"), STAT_LyhCombat_OnAttacked, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("ResolveHits"), STAT_LyhCombat_ResolveHits, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckEnemy"), STAT_LyhCombat_CheckEnemy, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("CheckAI"), STAT_LyhCombat_CheckAI, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("WeaponTrace"), STAT_LyhCombat_WeaponTrace, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits"), STAT_LyhCombat_Hits, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_LyhCombat_Traces, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Lock On Traces"), STAT_LyhCombat_LockOnTraces, STATGROUP_LyhCombat, LYHACTDEMO_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("States Started"), STAT_LyhCombat_StateTimers, STATGROUP_LyhCombat, LYHACTDEMO_API);
+
+/** Combat hot paths whose time and calls are counted */
+enum class ECombatCounter : uint8
+{
+	AttackEnemy,
+	Dodge,
+	OnAttacked,
+	ResolveHits,
+	CheckEnemy,
+	CheckAI,
+	WeaponTrace,
+	Num
+};
+
+/**
+ * Running totals of the combat hot paths, read and reset by the benchmark commandlet.
+ * Only touched from the game thread. Shipping builds compile the counting out and read zeros.
+ */
+struct FCombatCounters
+{
+	uint64 Cycles[(int32)ECombatCounter::Num];
+	uint32 Calls[(int32)ECombatCounter::Num];
+	/** Hits queued for resolution */
+	uint32 Hits;
+	/** Line of sight traces issued by monster perception */
+	uint32 Traces;
+	/** Line of sight traces of the player's lock on, see ALyhActDemoCharacter::CheckAI */
+	uint32 LockOnTraces;
+	/** Combat states started (combo, dodge, hurt), each one used to be a timer */
+	uint32 StateTimers;
+
+	FCombatCounters() { Reset(); }
+	void Reset() { FMemory::Memzero(*this); }
+
+	static const TCHAR* GetName(ECombatCounter Counter)
+	{
+		static const TCHAR* Names[] = { TEXT("AttackEnemy"), TEXT("Dodge"), TEXT("OnAttacked"), TEXT("ResolveHits"), TEXT("CheckEnemy"), TEXT("CheckAI"), TEXT("WeaponTrace") };
+		return Names[(int32)Counter];
+	}
+};
+
+extern LYHACTDEMO_API FCombatCounters GCombatCounters;
+
+#if !UE_BUILD_SHIPPING
+
+struct FCombatCounterScope
+{
+	explicit FCombatCounterScope(ECombatCounter InCounter)
+		: Counter((int32)InCounter)
+		, StartCycles(FPlatformTime::Cycles())
+	{
+	}
+	~FCombatCounterScope()
+	{
+		GCombatCounters.Cycles[Counter] += FPlatformTime::Cycles() - StartCycles;
+		GCombatCounters.Calls[Counter]++;
+	}
+	int32 Counter;
+	uint32 StartCycles;
+};
+
+/** Times the rest of the scope into both the benchmark counters and the cycle stat of the same name */
+#define COMBAT_COUNTER_SCOPE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_LyhCombat_##Name); \
+	FCombatCounterScope PREPROCESSOR_JOIN(CombatCounterScope_, __LINE__)(ECombatCounter::Name)
+#define COMBAT_COUNTER_INC(Field) \
+	{ \
+		INC_DWORD_STAT(STAT_LyhCombat_##Field); \
+		GCombatCounters.Field++; \
+	}
+
+#else
+
+#define COMBAT_COUNTER_SCOPE(Name)
+#define COMBAT_COUNTER_INC(Field)
+
+#endif
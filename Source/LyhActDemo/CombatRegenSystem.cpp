@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatRegenSystem.h"
+#include "CombatCharacter.h"
+
+void FCombatRegenSystem::Register(ACombatCharacter* Character)
+{
+	if (!Character || Owners.Contains(Character))
+	{
+		return;
+	}
+	const FPlayerStats& Stats = Character->GetCombatStats();
+	Owners.Add(Character);
+	Current.Add(Stats.Magic);
+	Max.Add(Character->GetBaseStats().Magic);
+	Rate.Add(Stats.MagicRegain);
+	Synced.Add(Stats.Magic);
+}
+
+void FCombatRegenSystem::Unregister(ACombatCharacter* Character)
+{
+	const int32 Index = Owners.IndexOfByKey(Character);
+	if (Index != INDEX_NONE)
+	{
+		RemoveAtSwap(Index);
+	}
+}
+
+void FCombatRegenSystem::RemoveAtSwap(int32 Index)
+{
+	Owners.RemoveAtSwap(Index, 1, false);
+	Current.RemoveAtSwap(Index, 1, false);
+	Max.RemoveAtSwap(Index, 1, false);
+	Rate.RemoveAtSwap(Index, 1, false);
+	Synced.RemoveAtSwap(Index, 1, false);
+}
+
+void FCombatRegenSystem::Update(float DeltaSeconds)
+{
+	// Gather what gameplay changed since last frame: spent magic and paused regen while defending
+	for (int32 Index = Owners.Num() - 1; Index >= 0; --Index)
+	{
+		ACombatCharacter* Owner = Owners[Index].Get();
+		if (!Owner)
+		{
+			RemoveAtSwap(Index);
+			continue;
+		}
+		const FPlayerStats& Stats = Owner->GetCombatStats();
+		if (Stats.Magic != Synced[Index])
+		{
+			Current[Index] = Stats.Magic;
+		}
+		Rate[Index] = Stats.MagicRegain;
+	}
+
+	const int32 Count = Owners.Num();
+	float* RESTRICT CurrentData = Current.GetData();
+	const float* RESTRICT MaxData = Max.GetData();
+	const float* RESTRICT RateData = Rate.GetData();
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const float Regained = FMath::Min(CurrentData[Index] + RateData[Index] * DeltaSeconds, MaxData[Index]);
+		CurrentData[Index] = FMath::Max(CurrentData[Index], Regained);
+	}
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		const int32 Magic = FMath::FloorToInt(CurrentData[Index]);
+		if (Magic != Synced[Index])
+		{
+			Synced[Index] = Magic;
+			Owners[Index]->GetCombatStats().Magic = Magic;
+		}
+	}
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class ACombatCharacter;
+
+/**
+ * Magic regeneration of every combatant in one loop. Current, max and rate live in parallel arrays;
+ * each frame they are gathered from the stats, advanced by a fractional per-frame amount and only
+ * the values whose integer part changed are written back.
+ */
+class LYHACTDEMO_API FCombatRegenSystem
+{
+public:
+	void Register(ACombatCharacter* Character);
+	void Unregister(ACombatCharacter* Character);
+	void Update(float DeltaSeconds);
+	int32 Num() const { return Owners.Num(); }
+private:
+	void RemoveAtSwap(int32 Index);
+
+	TArray<TWeakObjectPtr<ACombatCharacter>> Owners;
+	TArray<float> Current;
+	TArray<float> Max;
+	/** Per second */
+	TArray<float> Rate;
+	/** Magic written back last frame, a different value means it was spent in between */
+	TArray<int32> Synced;
+};
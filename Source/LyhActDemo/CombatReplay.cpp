@@ -0,0 +1,294 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatReplay.h"
+#include "LyhActDemo.h"
+#include "CombatCharacter.h"
+#include "CombatManager.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace CombatReplay
+{
+	/** Events are written to the file in blocks of about this many bytes */
+	const int32 ChunkSize = 64 * 1024;
+	/** Steps between two position updates of a combatant */
+	const uint32 LocateInterval = 10;
+	/** Combatants that moved less than this since their last position update are skipped */
+	const float MinLocateDistance = 5.f;
+}
+
+FArchive& operator<<(FArchive& Ar, FCombatReplayEvent& Event)
+{
+	// Most steps are small numbers, packed they take a byte or two
+	Ar.SerializeIntPacked(Event.Step);
+	uint8 Type = (uint8)Event.Type;
+	Ar << Type;
+	Event.Type = (ECombatReplayEvent)Type;
+	Ar << Event.Actor;
+	switch (Event.Type)
+	{
+	case ECombatReplayEvent::Spawn:
+		Ar << Event.ClassPath << Event.Location << Event.Value;
+		break;
+	case ECombatReplayEvent::Input:
+		Ar << Event.Code;
+		break;
+	case ECombatReplayEvent::Axis:
+		Ar << Event.Code << Event.Value;
+		break;
+	case ECombatReplayEvent::Hit:
+		Ar << Event.Other << Event.Location;
+		break;
+	case ECombatReplayEvent::Locate:
+		Ar << Event.Location << Event.Value;
+		break;
+	default:
+		break;
+	}
+	return Ar;
+}
+
+bool FCombatReplayRecorder::Start(const FString& Filename, int32 StepRate, int32 Seed)
+{
+	Stop();
+	File = IFileManager::Get().CreateFileWriter(*Filename);
+	if (!File)
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Combat replay: could not open %s for writing"), *Filename);
+		return false;
+	}
+	FCombatReplayHeader Header;
+	Header.Magic = FCombatReplayHeader::ExpectedMagic;
+	Header.Version = FCombatReplayHeader::CurrentVersion;
+	Header.StepRate = StepRate;
+	Header.Seed = Seed;
+	*File << Header;
+	Chunk.Reset(CombatReplay::ChunkSize);
+	ActorIds.Reset();
+	Actors.Reset();
+	LastLocateStep = Step;
+	return true;
+}
+
+void FCombatReplayRecorder::Stop()
+{
+	if (!File)
+	{
+		return;
+	}
+	Flush();
+	File->Close();
+	delete File;
+	File = nullptr;
+	ActorIds.Reset();
+	Actors.Reset();
+}
+
+void FCombatReplayRecorder::Write(FCombatReplayEvent& Event)
+{
+	Event.Step = Step;
+	FMemoryWriter Writer(Chunk, false, true);
+	Writer << Event;
+	if (Chunk.Num() >= CombatReplay::ChunkSize)
+	{
+		Flush();
+	}
+}
+
+void FCombatReplayRecorder::Flush()
+{
+	if (File && Chunk.Num() > 0)
+	{
+		File->Serialize(Chunk.GetData(), Chunk.Num());
+		Chunk.Reset();
+	}
+}
+
+uint16 FCombatReplayRecorder::GetActorId(ACombatCharacter* Character)
+{
+	if (const uint16* Id = ActorIds.Find(Character))
+	{
+		return *Id;
+	}
+	if (!ensureMsgf(Actors.Num() < MAX_uint16, TEXT("Combat replay: too many combatants")))
+	{
+		return MAX_uint16;
+	}
+	const uint16 Id = (uint16)Actors.Num();
+	ActorIds.Add(Character, Id);
+	FActor Actor;
+	Actor.LastLocation = Character->GetActorLocation();
+	Actor.LastAxis[0] = 0.f;
+	Actor.LastAxis[1] = 0.f;
+	Actors.Add(Actor);
+
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::Spawn;
+	Event.Actor = Id;
+	Event.ClassPath = Character->GetClass()->GetPathName();
+	Event.Location = Actor.LastLocation;
+	Event.Value = Character->GetActorRotation().Yaw;
+	Write(Event);
+	return Id;
+}
+
+void FCombatReplayRecorder::RecordInput(ACombatCharacter* Character, ECombatInput Input)
+{
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::Input;
+	Event.Actor = GetActorId(Character);
+	Event.Code = (uint8)Input;
+	Write(Event);
+}
+
+void FCombatReplayRecorder::RecordReleaseDefence(ACombatCharacter* Character)
+{
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::ReleaseDefence;
+	Event.Actor = GetActorId(Character);
+	Write(Event);
+}
+
+void FCombatReplayRecorder::RecordAxis(ACombatCharacter* Character, uint8 Axis, float Value)
+{
+	// Axes are polled every frame, only changes are worth a record
+	const uint16 Id = GetActorId(Character);
+	if (!Actors.IsValidIndex(Id) || Axis > 1 || Actors[Id].LastAxis[Axis] == Value)
+	{
+		return;
+	}
+	Actors[Id].LastAxis[Axis] = Value;
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::Axis;
+	Event.Actor = Id;
+	Event.Code = Axis;
+	Event.Value = Value;
+	Write(Event);
+}
+
+void FCombatReplayRecorder::RecordAttack(ACombatCharacter* Character)
+{
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::Attack;
+	Event.Actor = GetActorId(Character);
+	Write(Event);
+}
+
+void FCombatReplayRecorder::RecordHit(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint)
+{
+	FCombatReplayEvent Event;
+	Event.Type = ECombatReplayEvent::Hit;
+	Event.Actor = GetActorId(Victim);
+	Event.Other = Attacker ? GetActorId(Attacker) : MAX_uint16;
+	Event.Location = AttackPoint;
+	Write(Event);
+}
+
+void FCombatReplayRecorder::RecordLocations(const TArray<TWeakObjectPtr<ACombatCharacter>>& Combatants)
+{
+	if (Step - LastLocateStep < CombatReplay::LocateInterval)
+	{
+		return;
+	}
+	LastLocateStep = Step;
+	for (const TWeakObjectPtr<ACombatCharacter>& Combatant : Combatants)
+	{
+		ACombatCharacter* Character = Combatant.Get();
+		if (!Character)
+		{
+			continue;
+		}
+		const uint16 Id = GetActorId(Character);
+		const FVector Location = Character->GetActorLocation();
+		if (!Actors.IsValidIndex(Id) || FVector::DistSquared(Location, Actors[Id].LastLocation) < FMath::Square(CombatReplay::MinLocateDistance))
+		{
+			continue;
+		}
+		Actors[Id].LastLocation = Location;
+		FCombatReplayEvent Event;
+		Event.Type = ECombatReplayEvent::Locate;
+		Event.Actor = Id;
+		Event.Location = Location;
+		Event.Value = Character->GetActorRotation().Yaw;
+		Write(Event);
+	}
+}
+
+bool FCombatReplayReader::Open(const FString& Filename)
+{
+	Close();
+	File = IFileManager::Get().CreateFileReader(*Filename);
+	if (!File)
+	{
+		return false;
+	}
+	*File << Header;
+	if (File->IsError() || Header.Magic != FCombatReplayHeader::ExpectedMagic || Header.Version != FCombatReplayHeader::CurrentVersion)
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Combat replay: %s is not a replay of this version"), *Filename);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void FCombatReplayReader::Close()
+{
+	delete File;
+	File = nullptr;
+	bHasNext = false;
+}
+
+const FCombatReplayEvent* FCombatReplayReader::Peek()
+{
+	if (!bHasNext)
+	{
+		if (!File || File->AtEnd())
+		{
+			return nullptr;
+		}
+		*File << Next;
+		if (File->IsError() || Next.Type >= ECombatReplayEvent::Num)
+		{
+			UE_LOG(LogLyhCombat, Warning, TEXT("Combat replay: file ends in a broken event"));
+			Close();
+			return nullptr;
+		}
+		bHasNext = true;
+	}
+	return &Next;
+}
+
+static void StartCombatReplay(const TArray<FString>& Args, UWorld* World)
+{
+	ACombatManager* Manager = ACombatManager::Get(World);
+	if (!Manager)
+	{
+		return;
+	}
+	const FString Filename = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("Replays") / FString::Printf(TEXT("Combat-%s.lyhreplay"), *FDateTime::Now().ToString());
+	if (Manager->StartReplayRecording(Filename))
+	{
+		UE_LOG(LogLyhCombat, Display, TEXT("Combat replay: recording to %s"), *Filename);
+	}
+}
+
+static void StopCombatReplay(UWorld* World)
+{
+	if (ACombatManager* Manager = ACombatManager::Get(World))
+	{
+		Manager->StopReplayRecording();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GStartCombatReplayCommand(
+	TEXT("Lyh.ReplayRecord"),
+	TEXT("Records the fight of this world to a replay file until Lyh.ReplayStop. Lyh.ReplayRecord [Filename]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartCombatReplay));
+
+static FAutoConsoleCommandWithWorld GStopCombatReplayCommand(
+	TEXT("Lyh.ReplayStop"),
+	TEXT("Finishes the replay started with Lyh.ReplayRecord"),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&StopCombatReplay));
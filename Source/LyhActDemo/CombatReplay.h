@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include "CombatInputBuffer.h"
+
+class ACombatCharacter;
+class FArchive;
+
+enum class ECombatReplayEvent : uint8
+{
+	/** First event of a combatant, carries its class and where it stood */
+	Spawn,
+	Input,
+	ReleaseDefence,
+	/** MoveForward (Code 0) or MoveRight (Code 1) changed to Value */
+	Axis,
+	/** Behavior tree of a monster called AttackEnemy */
+	Attack,
+	/** Hit taken from Other, INDEX_NONE when nobody */
+	Hit,
+	/** Periodic position, movement itself is not recorded */
+	Locate,
+	Num
+};
+
+/** One entry of a replay file; which fields are written depends on Type */
+struct LYHACTDEMO_API FCombatReplayEvent
+{
+	uint32 Step = 0;
+	ECombatReplayEvent Type = ECombatReplayEvent::Num;
+	uint16 Actor = 0;
+	uint16 Other = 0;
+	uint8 Code = 0;
+	float Value = 0.f;
+	FVector Location = FVector::ZeroVector;
+	FString ClassPath;
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatReplayEvent& Event);
+};
+
+/** File header, StepRate and Seed are what ACombatManager::SetFixedStep needs to replay the fight */
+struct FCombatReplayHeader
+{
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 StepRate = 30;
+	int32 Seed = 0;
+
+	static const uint32 ExpectedMagic = 0x5259484C;
+	static const uint32 CurrentVersion = 1;
+
+	friend FArchive& operator<<(FArchive& Ar, FCombatReplayHeader& Header)
+	{
+		return Ar << Header.Magic << Header.Version << Header.StepRate << Header.Seed;
+	}
+};
+
+/**
+ * Streams the inputs, AI attack decisions and hits of a fight to a file, stamped with the combat
+ * step they happened on. Events are packed into a fixed size chunk that is written out whenever it
+ * fills up, so a recording of any length keeps the same small amount of memory.
+ */
+class LYHACTDEMO_API FCombatReplayRecorder
+{
+public:
+	~FCombatReplayRecorder() { Stop(); }
+
+	bool Start(const FString& Filename, int32 StepRate, int32 Seed);
+	void Stop();
+	bool IsRecording() const { return File != nullptr; }
+	/** Combat step the following events are stamped with */
+	void SetStep(uint32 InStep) { Step = InStep; }
+
+	void RecordInput(ACombatCharacter* Character, ECombatInput Input);
+	void RecordReleaseDefence(ACombatCharacter* Character);
+	void RecordAxis(ACombatCharacter* Character, uint8 Axis, float Value);
+	void RecordAttack(ACombatCharacter* Character);
+	void RecordHit(ACombatCharacter* Victim, ACombatCharacter* Attacker, const FVector& AttackPoint);
+	/** Writes where the combatants that moved are, every few steps */
+	void RecordLocations(const TArray<TWeakObjectPtr<ACombatCharacter>>& Combatants);
+private:
+	/** Replay id of Character, writing its spawn event the first time it shows up */
+	uint16 GetActorId(ACombatCharacter* Character);
+	void Write(FCombatReplayEvent& Event);
+	void Flush();
+
+	struct FActor
+	{
+		FVector LastLocation;
+		float LastAxis[2];
+	};
+
+	FArchive* File = nullptr;
+	TArray<uint8> Chunk;
+	TMap<TWeakObjectPtr<ACombatCharacter>, uint16> ActorIds;
+	TArray<FActor> Actors;
+	uint32 Step = 0;
+	uint32 LastLocateStep = 0;
+};
+
+/** Reads a replay file event by event, holding no more than the file reader's buffer */
+class LYHACTDEMO_API FCombatReplayReader
+{
+public:
+	~FCombatReplayReader() { Close(); }
+
+	bool Open(const FString& Filename);
+	void Close();
+	const FCombatReplayHeader& GetHeader() const { return Header; }
+
+	/** Next event without consuming it, null at the end of the file */
+	const FCombatReplayEvent* Peek();
+	void Pop() { bHasNext = false; }
+private:
+	FArchive* File = nullptr;
+	FCombatReplayHeader Header;
+	FCombatReplayEvent Next;
+	bool bHasNext = false;
+};
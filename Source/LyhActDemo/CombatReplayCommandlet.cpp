@@ -0,0 +1,211 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatReplayCommandlet.h"
+#include "LyhActDemo.h"
+#include "AICharacter.h"
+#include "CombatManager.h"
+#include "CombatReplay.h"
+#include "WeaponTraceComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Misc/App.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+
+UCombatReplayCommandlet::UCombatReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+ACombatCharacter* UCombatReplayCommandlet::GetActor(uint16 Id) const
+{
+	return Actors.IsValidIndex(Id) ? Actors[Id] : nullptr;
+}
+
+void UCombatReplayCommandlet::Apply(UWorld* World, const FCombatReplayEvent& Event)
+{
+	if (Event.Type == ECombatReplayEvent::Spawn)
+	{
+		UClass* Class = LoadClass<ACombatCharacter>(nullptr, *Event.ClassPath);
+		const FTransform SpawnTransform(FRotator(0.f, Event.Value, 0.f), Event.Location);
+		ACombatCharacter* Character = Class ? World->SpawnActorDeferred<ACombatCharacter>(Class, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn) : nullptr;
+		if (Character)
+		{
+			// No AI controller and so no behavior tree, the recorded attack decisions drive the monsters
+			Character->AutoPossessAI = EAutoPossessAI::Disabled;
+			Character->AutoPossessPlayer = EAutoReceiveInput::Disabled;
+			Character->FinishSpawning(SpawnTransform);
+		}
+		if (!Character)
+		{
+			UE_LOG(LogLyhCombat, Warning, TEXT("CombatReplay: could not spawn %s, its events are skipped"), *Event.ClassPath);
+		}
+		else
+		{
+			// The world has no floor; positions come from the replay anyway
+			Character->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+			// Recorded hits are applied as they are, traces would count them twice
+			TArray<UWeaponTraceComponent*> Traces;
+			Character->GetComponents(Traces);
+			for (UWeaponTraceComponent* Trace : Traces)
+			{
+				Trace->SetComponentTickEnabled(false);
+			}
+		}
+		if (Actors.Num() <= Event.Actor)
+		{
+			Actors.SetNumZeroed(Event.Actor + 1);
+		}
+		Actors[Event.Actor] = Character;
+		return;
+	}
+
+	ACombatCharacter* Character = GetActor(Event.Actor);
+	if (!Character)
+	{
+		return;
+	}
+	switch (Event.Type)
+	{
+	case ECombatReplayEvent::Input:
+		Character->BufferInput((ECombatInput)Event.Code);
+		break;
+	case ECombatReplayEvent::ReleaseDefence:
+		Character->ReleaseDefence();
+		break;
+	case ECombatReplayEvent::Axis:
+		// Only the side axis matters to combat, it picks the dodge direction
+		if (Event.Code == 1)
+		{
+			Character->LeftVector = Event.Value < 0.f ? 1 : 0;
+			Character->RightVextor = Event.Value > 0.f ? 1 : 0;
+		}
+		break;
+	case ECombatReplayEvent::Attack:
+		Character->AttackEnemy();
+		break;
+	case ECombatReplayEvent::Hit:
+		if (ACombatManager* Manager = ACombatManager::Get(Character))
+		{
+			Manager->ApplyReplayHit(Character, GetActor(Event.Other), Event.Location);
+		}
+		break;
+	case ECombatReplayEvent::Locate:
+	{
+		const FTransform Transform(FRotator(0.f, Event.Value, 0.f), Event.Location);
+		AAICharacter* Monster = Cast<AAICharacter>(Character);
+		if (Monster && Monster->IsPooled())
+		{
+			// Came back from the pool in the recording
+			Monster->Reactivate(Transform);
+			Monster->GetCharacterMovement()->SetMovementMode(MOVE_Flying);
+		}
+		else
+		{
+			Character->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+namespace CombatReplayPlayback
+{
+	void WriteLine(FArchive* File, const FString& Line)
+	{
+		if (File)
+		{
+			FTCHARToUTF8 Utf8(*Line);
+			File->Serialize((void*)Utf8.Get(), Utf8.Length());
+		}
+	}
+}
+
+int32 UCombatReplayCommandlet::Main(const FString& Params)
+{
+	FString ReplayPath;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmark/CombatReplay.csv");
+	FParse::Value(*Params, TEXT("Replay="), ReplayPath);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FCombatReplayReader Reader;
+	if (ReplayPath.IsEmpty() || !Reader.Open(ReplayPath))
+	{
+		UE_LOG(LogLyhCombat, Error, TEXT("CombatReplay: could not open the replay, pass -Replay="));
+		return 1;
+	}
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("CombatReplay"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->GetWorldSettings()->NotifyBeginPlay();
+	ACombatManager* Manager = ACombatManager::Get(World);
+	if (!Manager)
+	{
+		UE_LOG(LogLyhCombat, Error, TEXT("CombatReplay: no combat manager in the playback world"));
+		return 1;
+	}
+	const FCombatReplayHeader& Header = Reader.GetHeader();
+	Manager->SetFixedStep(true, Header.StepRate, Header.Seed);
+	// Swords of the replayed swings still overlap, their hits are already in the replay
+	Manager->SetReplayPlayback(true);
+	const float DeltaTime = 1.f / FMath::Max(Header.StepRate, 1);
+
+	// Replay steps count from wherever the recording world was, playback lines its own up with the first event
+	const FCombatReplayEvent* First = Reader.Peek();
+	uint32 Step = First ? First->Step : 0;
+	TArray<double> StepMs;
+	// Streamed out like the replay itself, however long it is
+	FArchive* Csv = IFileManager::Get().CreateFileWriter(*OutputPath);
+	CombatReplayPlayback::WriteLine(Csv, TEXT("Step,StepMs,Events\n"));
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	while (Reader.Peek())
+	{
+		const uint64 StepStartCycles = FPlatformTime::Cycles64();
+		int32 NumEvents = 0;
+		for (const FCombatReplayEvent* Event = Reader.Peek(); Event && Event->Step <= Step; Event = Reader.Peek())
+		{
+			Apply(World, *Event);
+			Reader.Pop();
+			NumEvents++;
+		}
+		FApp::SetDeltaTime(DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+		const double Ms = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StepStartCycles) * 1000.0;
+		StepMs.Add(Ms);
+		CombatReplayPlayback::WriteLine(Csv, FString::Printf(TEXT("%u,%.4f,%d\n"), Step, Ms, NumEvents));
+		Step++;
+	}
+	const double WallSeconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	TArray<double> Sorted = StepMs;
+	Sorted.Sort();
+	const double GameSeconds = StepMs.Num() * (double)DeltaTime;
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatReplay: %s Combatants=%d Steps=%d StepRate=%d"), *ReplayPath, Actors.Num(), StepMs.Num(), Header.StepRate);
+	UE_LOG(LogLyhCombat, Display, TEXT("CombatReplay: StepMs Avg=%.3f P50=%.3f P95=%.3f Max=%.3f, %.1fs of play in %.1fs (x%.1f)"),
+		StepMs.Num() ? WallSeconds * 1000.0 / StepMs.Num() : 0.0,
+		Sorted.Num() ? Sorted[Sorted.Num() / 2] : 0.0, Sorted.Num() ? Sorted[FMath::Min(FMath::FloorToInt(Sorted.Num() * 0.95f), Sorted.Num() - 1)] : 0.0, Sorted.Num() ? Sorted.Last() : 0.0,
+		GameSeconds, WallSeconds, WallSeconds > 0.0 ? GameSeconds / WallSeconds : 0.0);
+	if (Csv)
+	{
+		Csv->Close();
+		delete Csv;
+		UE_LOG(LogLyhCombat, Display, TEXT("CombatReplay: per step numbers written to %s"), *OutputPath);
+	}
+
+	Actors.Reset();
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return 0;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatReplayCommandlet.generated.h"
+
+class ACombatCharacter;
+struct FCombatReplayEvent;
+
+/**
+ * Headless playback of a replay recorded with Lyh.ReplayRecord. Spawns the recorded combatants in
+ * an empty world and feeds their inputs, attack decisions, hits and positions back step by step
+ * as fast as the machine goes, then reports the time per step like the combat benchmark.
+ *
+ *   UE4Editor-Cmd LyhActDemo.uproject -run=CombatReplay -nullrhi -unattended
+ *       -Replay=Saved/Replays/Combat-....lyhreplay [-Output=Saved/Benchmark/CombatReplay.csv]
+ *
+ * Behavior trees do not run and live weapon hits are ignored during playback, their outcome is in the replay.
+ */
+UCLASS()
+class UCombatReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UCombatReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+private:
+	void Apply(UWorld* World, const FCombatReplayEvent& Event);
+	ACombatCharacter* GetActor(uint16 Id) const;
+
+	/** Indexed by replay actor id */
+	UPROPERTY()
+	TArray<ACombatCharacter*> Actors;
+};
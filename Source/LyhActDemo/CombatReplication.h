@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatReplication.generated.h"
+
+/**
+ * Combat state of a character: the six state flags and ComboNum in one byte, Blood and Magic as
+ * packed integers so small values stay small on the wire without capping large ones. Set on the
+ * server right before replication.
+ */
+USTRUCT()
+struct LYHACTDEMO_API FCombatRepState
+{
+	GENERATED_USTRUCT_BODY()
+
+	enum
+	{
+		NumFlagBits = 6,
+		NumComboBits = 2,
+		NumBits = NumFlagBits + NumComboBits,
+	};
+
+	/** Flags in bits 0-5, ComboNum 6-7 */
+	UPROPERTY()
+	uint8 Packed = 0;
+
+	UPROPERTY()
+	uint32 Blood = 0;
+
+	UPROPERTY()
+	uint32 Magic = 0;
+
+	void Set(uint8 Flags, uint8 ComboNum, int32 InBlood, int32 InMagic)
+	{
+		Packed = (Flags & ((1 << NumFlagBits) - 1))
+			| (ComboNum & ((1 << NumComboBits) - 1)) << NumFlagBits;
+		// Clients show a dead character at 0 like the server
+		Blood = FMath::Max(InBlood, 0);
+		Magic = FMath::Max(InMagic, 0);
+	}
+	uint8 GetFlags() const { return Packed & ((1 << NumFlagBits) - 1); }
+	uint8 GetComboNum() const { return (Packed >> NumFlagBits) & ((1 << NumComboBits) - 1); }
+	int32 GetBlood() const { return Blood; }
+	int32 GetMagic() const { return Magic; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		if (Ar.IsLoading())
+		{
+			Packed = 0;
+		}
+		Ar.SerializeBits(&Packed, NumBits);
+		Ar.SerializeIntPacked(Blood);
+		Ar.SerializeIntPacked(Magic);
+		bOutSuccess = true;
+		return true;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatRepState> : public TStructOpsTypeTraitsBase2<FCombatRepState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
+/**
+ * Last combat montage the server played, as its id in the character's montage set. Id 0 stops the
+ * montages. The counter changes with every play so replaying the same montage is still sent. The
+ * server time it started at lets clients that only now see the character skip montages that are over.
+ */
+USTRUCT()
+struct LYHACTDEMO_API FCombatMontageRep
+{
+	GENERATED_USTRUCT_BODY()
+
+	enum
+	{
+		NumIdBits = 8,
+		NumCounterBits = 4,
+	};
+
+	UPROPERTY()
+	uint8 Id = 0;
+
+	UPROPERTY()
+	uint8 Counter = 0;
+
+	/** Server world time the montage started at */
+	UPROPERTY()
+	float StartTime = 0.f;
+
+	void Set(uint8 InId, float InStartTime)
+	{
+		Id = InId;
+		Counter = (Counter + 1) & ((1 << NumCounterBits) - 1);
+		StartTime = InStartTime;
+	}
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		uint16 Bits = Id | uint16(Counter) << NumIdBits;
+		if (Ar.IsLoading())
+		{
+			Bits = 0;
+		}
+		Ar.SerializeBits(&Bits, NumIdBits + NumCounterBits);
+		Id = Bits & ((1 << NumIdBits) - 1);
+		Counter = Bits >> NumIdBits;
+		// A stop does not need its start time
+		if (Id != 0)
+		{
+			Ar << StartTime;
+		}
+		bOutSuccess = true;
+		return true;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FCombatMontageRep> : public TStructOpsTypeTraitsBase2<FCombatMontageRep>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatStatsRegistry.h"
+#include "LyhActDemo.h"
+#include "CombatCharacter.h"
+#include "Engine/DataTable.h"
+#include "UObject/UObjectIterator.h"
+
+namespace CombatStatsRegistry
+{
+	const TCHAR* TablePath = TEXT("/Game/Common/stats.stats");
+}
+
+FCombatStatsRegistry& FCombatStatsRegistry::Get()
+{
+	static FCombatStatsRegistry Registry;
+	return Registry;
+}
+
+FCombatStatsRegistry::FCombatStatsRegistry()
+{
+	BaseStats.AddZeroed();
+}
+
+void FCombatStatsRegistry::Initialize()
+{
+	if (!bLoaded)
+	{
+		LoadTable();
+	}
+	ResolveClasses();
+}
+
+void FCombatStatsRegistry::LoadTable()
+{
+	bLoaded = true;
+	UDataTable* Table = LoadObject<UDataTable>(nullptr, CombatStatsRegistry::TablePath);
+	if (!ensureMsgf(Table, TEXT("Stats table %s could not be loaded, every character starts with zeroed stats"), CombatStatsRegistry::TablePath))
+	{
+		return;
+	}
+	if (!ensureMsgf(Table->RowStruct && Table->RowStruct->IsChildOf(FPlayerStats::StaticStruct()), TEXT("Stats table %s does not use FPlayerStats rows"), CombatStatsRegistry::TablePath))
+	{
+		return;
+	}
+	CopyRows(Table);
+	LoadedTable = Table;
+#if WITH_EDITOR
+	Table->OnDataTableChanged().AddRaw(this, &FCombatStatsRegistry::OnTableChanged);
+#endif
+}
+
+void FCombatStatsRegistry::CopyRows(const UDataTable* Table)
+{
+	// The rows are copied out, the table itself is not needed afterwards. Known rows keep their id
+	for (const TPair<FName, uint8*>& Row : Table->RowMap)
+	{
+		const FPlayerStats& Stats = *reinterpret_cast<const FPlayerStats*>(Row.Value);
+		if (const int32* StatsId = RowIds.Find(Row.Key))
+		{
+			BaseStats[*StatsId] = Stats;
+		}
+		else
+		{
+			RowIds.Add(Row.Key, BaseStats.Num());
+			BaseStats.Add(Stats);
+		}
+	}
+}
+
+void FCombatStatsRegistry::ResolveClasses()
+{
+	// Blueprint classes loaded later resolve their row when their first instance is initialized
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		if (It->IsChildOf(ACombatCharacter::StaticClass()) && !It->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists))
+		{
+			ACombatCharacter* Defaults = It->GetDefaultObject<ACombatCharacter>();
+			Defaults->StatsId = FindStatsId(Defaults->StatsRow);
+		}
+	}
+}
+
+void FCombatStatsRegistry::OnTableChanged()
+{
+	if (const UDataTable* Table = LoadedTable.Get())
+	{
+		UE_LOG(LogLyhCombat, Log, TEXT("Stats table %s changed, copying its rows again"), CombatStatsRegistry::TablePath);
+		CopyRows(Table);
+		// Rows added since may be the ones that were missing
+		ResolveClasses();
+	}
+}
+
+int32 FCombatStatsRegistry::FindStatsId(FName RowName)
+{
+	// Commandlets can resolve rows before the game module initialized the registry
+	if (!bLoaded)
+	{
+		LoadTable();
+	}
+	if (const int32* StatsId = RowIds.Find(RowName))
+	{
+		return *StatsId;
+	}
+	ensureMsgf(false, TEXT("Stats row '%s' is missing from %s"), *RowName.ToString(), CombatStatsRegistry::TablePath);
+	return 0;
+}
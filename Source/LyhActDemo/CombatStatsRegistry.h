@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include "PlayerStats.h"
+
+class UDataTable;
+
+/**
+ * Read-only base stats of every row of /Game/Common/stats. The table is loaded when the engine has
+ * started and its rows are copied into a flat array, so after a row name has been resolved to an id
+ * a lookup is an index. The rows of every combat character class loaded by then are resolved right
+ * away. Id 0 is a zeroed row that missing rows resolve to after failing an ensure. In the editor a
+ * re-imported table is copied again, row ids stay the same.
+ */
+class LYHACTDEMO_API FCombatStatsRegistry
+{
+public:
+	static FCombatStatsRegistry& Get();
+
+	/** Loads the table and resolves StatsRow of the loaded combat character classes, called by the game module */
+	void Initialize();
+
+	/** Resolves a row name, fails an ensure and returns 0 when the row does not exist. Not for the hot path */
+	int32 FindStatsId(FName RowName);
+
+	const FPlayerStats& GetBaseStats(int32 StatsId) const
+	{
+		return BaseStats.IsValidIndex(StatsId) ? BaseStats[StatsId] : BaseStats[0];
+	}
+private:
+	FCombatStatsRegistry();
+	void LoadTable();
+	void CopyRows(const UDataTable* Table);
+	void ResolveClasses();
+	void OnTableChanged();
+
+	bool bLoaded = false;
+	TArray<FPlayerStats> BaseStats;
+	TMap<FName, int32> RowIds;
+	TWeakObjectPtr<UDataTable> LoadedTable;
+};
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CombatTargetGrid.h"
+#include "CombatCharacter.h"
+
+FCombatTargetGrid::FCombatTargetGrid(float InCellSize)
+	: BucketMask(0)
+{
+	SetCellSize(InCellSize);
+	BucketStart.Init(0, 2);
+}
+
+void FCombatTargetGrid::SetCellSize(float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 100.f);
+	InvCellSize = 1.f / CellSize;
+}
+
+void FCombatTargetGrid::Register(ACombatCharacter* Character)
+{
+	Members.AddUnique(Character);
+}
+
+void FCombatTargetGrid::Unregister(ACombatCharacter* Character)
+{
+	Members.RemoveSwap(Character);
+	// Entries still points at it until the next rebuild
+	for (FEntry& Entry : Entries)
+	{
+		if (Entry.Character == Character)
+		{
+			Entry.Character = nullptr;
+		}
+	}
+}
+
+void FCombatTargetGrid::Rebuild()
+{
+	Members.RemoveAllSwap([](const TWeakObjectPtr<ACombatCharacter>& Member) { return !Member.IsValid(); });
+
+	// Twice as many buckets as characters keeps the chains short
+	const int32 NumBuckets = FMath::RoundUpToPowerOfTwo(FMath::Max(Members.Num() * 2, 64));
+	BucketMask = NumBuckets - 1;
+	BucketStart.Reset(NumBuckets + 1);
+	BucketStart.AddZeroed(NumBuckets + 1);
+
+	Unsorted.Reset(Members.Num());
+	EntryBuckets.Reset(Members.Num());
+	for (const TWeakObjectPtr<ACombatCharacter>& Member : Members)
+	{
+		FEntry Entry;
+		Entry.Character = Member.Get();
+		Entry.Location = Entry.Character->GetActorLocation();
+		Entry.CellX = CellCoord(Entry.Location.X);
+		Entry.CellY = CellCoord(Entry.Location.Y);
+		const uint32 Bucket = BucketOf(Entry.CellX, Entry.CellY);
+		EntryBuckets.Add(Bucket);
+		BucketStart[Bucket + 1]++;
+		Unsorted.Add(Entry);
+	}
+
+	// Counting sort by bucket
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		BucketStart[Bucket + 1] += BucketStart[Bucket];
+	}
+	Cursor.Reset(NumBuckets);
+	Cursor.Append(BucketStart.GetData(), NumBuckets);
+	Entries.SetNumUninitialized(Unsorted.Num(), false);
+	for (int32 Index = 0; Index < Unsorted.Num(); ++Index)
+	{
+		Entries[Cursor[EntryBuckets[Index]]++] = Unsorted[Index];
+	}
+}
+
+int32 FCombatTargetGrid::Query(const FCombatTargetQuery& Query, TArray<FCombatTarget>& OutTargets) const
+{
+	OutTargets.Reset();
+	if (Entries.Num() == 0 || Query.MaxCount <= 0)
+	{
+		return 0;
+	}
+
+	const float RadiusSquared = FMath::Square(Query.Radius);
+	const bool bUseCone = Query.HalfAngle < 180.f;
+	const FVector Forward2D = FVector(Query.Forward.X, Query.Forward.Y, 0.f).GetSafeNormal();
+	const float MinCos = FMath::Cos(FMath::DegreesToRadians(Query.HalfAngle));
+
+	const int32 MinX = CellCoord(Query.Origin.X - Query.Radius);
+	const int32 MaxX = CellCoord(Query.Origin.X + Query.Radius);
+	const int32 MinY = CellCoord(Query.Origin.Y - Query.Radius);
+	const int32 MaxY = CellCoord(Query.Origin.Y + Query.Radius);
+	for (int32 CellX = MinX; CellX <= MaxX; ++CellX)
+	{
+		for (int32 CellY = MinY; CellY <= MaxY; ++CellY)
+		{
+			const uint32 Bucket = BucketOf(CellX, CellY);
+			for (int32 Index = BucketStart[Bucket]; Index < BucketStart[Bucket + 1]; ++Index)
+			{
+				const FEntry& Entry = Entries[Index];
+				// Buckets are shared by every cell hashing to them
+				if (Entry.CellX != CellX || Entry.CellY != CellY || !Entry.Character)
+				{
+					continue;
+				}
+				const FVector Delta = Entry.Location - Query.Origin;
+				const float DistSquared = Delta.SizeSquared();
+				if (DistSquared > RadiusSquared || Entry.Character == Query.IgnoreActor || Entry.Character->bIsDeath)
+				{
+					continue;
+				}
+				if (bUseCone)
+				{
+					const FVector Delta2D = FVector(Delta.X, Delta.Y, 0.f).GetSafeNormal();
+					if ((Delta2D | Forward2D) < MinCos)
+					{
+						continue;
+					}
+				}
+				if (Query.TargetClass && !Entry.Character->IsA(Query.TargetClass))
+				{
+					continue;
+				}
+				if (Query.ActorsToIgnore && Query.ActorsToIgnore->Contains(Entry.Character))
+				{
+					continue;
+				}
+				FCombatTarget Target;
+				Target.Character = Entry.Character;
+				Target.DistSquared = DistSquared;
+				OutTargets.Add(Target);
+			}
+		}
+	}
+
+	OutTargets.Sort([](const FCombatTarget& A, const FCombatTarget& B) { return A.DistSquared < B.DistSquared; });
+	if (OutTargets.Num() > Query.MaxCount)
+	{
+		OutTargets.SetNum(Query.MaxCount, false);
+	}
+	return OutTargets.Num();
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AActor;
+class ACombatCharacter;
+
+/** What a perception query is looking for */
+struct FCombatTargetQuery
+{
+	FVector Origin = FVector::ZeroVector;
+	/** Facing of the querier, only X and Y are used */
+	FVector Forward = FVector::ForwardVector;
+	float Radius = 1000.f;
+	/** Half angle of the view cone in degrees, 180 or more disables the cone */
+	float HalfAngle = 180.f;
+	int32 MaxCount = 1;
+	/** Only characters of this class are returned, null accepts any */
+	UClass* TargetClass = nullptr;
+	const TArray<AActor*>* ActorsToIgnore = nullptr;
+	const AActor* IgnoreActor = nullptr;
+};
+
+struct FCombatTarget
+{
+	ACombatCharacter* Character;
+	float DistSquared;
+};
+
+/**
+ * Uniform grid over the registered combatants, hashed into a flat bucket table and rebuilt once
+ * per frame. Answers radius + cone queries without going through the physics scene.
+ */
+class LYHACTDEMO_API FCombatTargetGrid
+{
+public:
+	explicit FCombatTargetGrid(float InCellSize = 1000.f);
+
+	void SetCellSize(float InCellSize);
+	void Register(ACombatCharacter* Character);
+	void Unregister(ACombatCharacter* Character);
+	int32 NumRegistered() const { return Members.Num(); }
+
+	/** Re-buckets every registered character at its current location */
+	void Rebuild();
+
+	/** Fills OutTargets with up to Query.MaxCount characters sorted from the closest, returns how many were found */
+	int32 Query(const FCombatTargetQuery& Query, TArray<FCombatTarget>& OutTargets) const;
+private:
+	FORCEINLINE int32 CellCoord(float Value) const { return FMath::FloorToInt(Value * InvCellSize); }
+	FORCEINLINE uint32 BucketOf(int32 CellX, int32 CellY) const
+	{
+		return (uint32(CellX) * 73856093u ^ uint32(CellY) * 19349663u) & BucketMask;
+	}
+
+	struct FEntry
+	{
+		FVector Location;
+		ACombatCharacter* Character;
+		int32 CellX;
+		int32 CellY;
+	};
+
+	float CellSize;
+	float InvCellSize;
+	uint32 BucketMask;
+	TArray<TWeakObjectPtr<ACombatCharacter>> Members;
+	/** Entries sorted by bucket, BucketStart[B] .. BucketStart[B + 1] is bucket B */
+	TArray<FEntry> Entries;
+	TArray<int32> BucketStart;
+	/** Rebuild scratch */
+	TArray<FEntry> Unsorted;
+	TArray<uint32> EntryBuckets;
+	TArray<int32> Cursor;
+};
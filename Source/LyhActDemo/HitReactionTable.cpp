@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitReactionTable.h"
+
+UHitReactionTable::UHitReactionTable()
+{
+	BaseDamage = 10;
+
+	// Default zones of the mannequin: head top, head down, torso and legs. Head hits are critical
+	FHitZone HeadTop;
+	HeadTop.MinHeight = 53.f;
+	HeadTop.DamageMultiplier = 2.f;
+	Zones.Add(HeadTop);
+
+	FHitZone HeadDown;
+	HeadDown.MinHeight = 36.f;
+	HeadDown.DamageMultiplier = 2.f;
+	Zones.Add(HeadDown);
+
+	FHitZone Torso;
+	Torso.MinHeight = 0.f;
+	Torso.CenterHalfWidth = 10.f;
+	Zones.Add(Torso);
+
+	FHitZone Leg;
+	Leg.MinHeight = -96.f;
+	Leg.bIgnoreBack = true;
+	Zones.Add(Leg);
+}
+
+void UHitReactionTable::PostInitProperties()
+{
+	Super::PostInitProperties();
+	BuildLookup();
+}
+
+void UHitReactionTable::PostLoad()
+{
+	Super::PostLoad();
+	BuildLookup();
+}
+
+#if WITH_EDITOR
+void UHitReactionTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BuildLookup();
+}
+#endif
+
+void UHitReactionTable::BuildLookup()
+{
+	TArray<FHitZone> Sorted = Zones;
+	Sorted.Sort([](const FHitZone& A, const FHitZone& B) { return A.MinHeight > B.MinHeight; });
+
+	const int32 NumFacings = (int32)EHitFacing::MAX;
+	Bands.Reset(Sorted.Num());
+	Cells.Reset(Sorted.Num() * NumFacings);
+	for (const FHitZone& Zone : Sorted)
+	{
+		FBand Band;
+		Band.MinHeight = Zone.MinHeight;
+		Band.CenterHalfWidth = FMath::Max(Zone.CenterHalfWidth, 0.f);
+		Band.bIgnoreBack = Zone.bIgnoreBack;
+		Bands.Add(Band);
+
+		const int32 Damage = FMath::RoundToInt(BaseDamage * Zone.DamageMultiplier);
+		// A band without a centre column still gets a hit exactly on its middle line, like the right side did before the table
+		UAnimMontage* FrontCenter = Zone.FrontCenter ? Zone.FrontCenter : (Zone.FrontRight ? Zone.FrontRight : Zone.FrontLeft);
+		UAnimMontage* ByFacing[] = { Zone.Back, Zone.FrontLeft, FrontCenter, Zone.FrontRight };
+		for (int32 Facing = 0; Facing < NumFacings; ++Facing)
+		{
+			FHitReaction Cell;
+			Cell.Montage = ByFacing[Facing];
+			Cell.Damage = Damage;
+			Cells.Add(Cell);
+		}
+	}
+}
+
+void UHitReactionTable::Resolve(const FTransform& CharacterTrans, const FVector& AttackPoint, FHitReaction& OutReaction) const
+{
+	const int32 LastBand = Bands.Num() - 1;
+	if (LastBand < 0)
+	{
+		OutReaction = FHitReaction();
+		return;
+	}
+
+	const float Height = AttackPoint.Z - CharacterTrans.GetLocation().Z;
+	int32 Band = 0;
+	while (Band < LastBand && Height <= Bands[Band].MinHeight)
+	{
+		++Band;
+	}
+
+	// Lateral is 1 on the left, -1 on the right and 0 in the centre column; the back maps to facing 0
+	const FBand& Zone = Bands[Band];
+	const FVector Local = CharacterTrans.InverseTransformPosition(AttackPoint);
+	const int32 Lateral = int32(Local.X > Zone.CenterHalfWidth) - int32(Local.X < -Zone.CenterHalfWidth);
+	const int32 bFront = int32(Local.Y > 0.f) | int32(Zone.bIgnoreBack);
+	const int32 Facing = bFront * (2 - Lateral);
+	OutReaction = Cells[Band * (int32)EHitFacing::MAX + Facing];
+}
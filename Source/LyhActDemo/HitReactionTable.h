@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "HitReactionTable.generated.h"
+
+class UAnimMontage;
+
+/** Which side of the character a hit comes from, as seen in the character's local space */
+UENUM(BlueprintType)
+enum class EHitFacing : uint8
+{
+	Back,
+	FrontLeft,
+	FrontCenter,
+	FrontRight,
+	MAX UMETA(Hidden)
+};
+
+/** One height band of the character with a reaction per facing */
+USTRUCT(BlueprintType)
+struct LYHACTDEMO_API FHitZone
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Hits higher than this above the actor origin land in this zone. The lowest zone takes everything below */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float MinHeight = 0.f;
+	/** Half width of the front centre column in local X, 0 splits the front into left and right only */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float CenterHalfWidth = 0.f;
+	/** Hits from behind use the front reactions, e.g. legs */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bIgnoreBack = false;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	float DamageMultiplier = 1.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UAnimMontage* Back = nullptr;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UAnimMontage* FrontLeft = nullptr;
+	/** Falls back to FrontRight, then FrontLeft, for hits exactly on the middle line */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UAnimMontage* FrontCenter = nullptr;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UAnimMontage* FrontRight = nullptr;
+};
+
+/** Resolved reaction of a single hit */
+struct FHitReaction
+{
+	UAnimMontage* Montage = nullptr;
+	int32 Damage = 0;
+};
+
+/**
+ * Hit zones of one skeleton. The zones are flattened into a band x facing table on load,
+ * so resolving a hit is a short threshold scan plus an index instead of a branch tree.
+ */
+UCLASS(BlueprintType)
+class LYHACTDEMO_API UHitReactionTable : public UDataAsset
+{
+	GENERATED_BODY()
+public:
+	UHitReactionTable();
+
+	//扣血值应该为武器的属性,当前武器只有一种,属性固定为10
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Damage")
+	int32 BaseDamage;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Zones")
+	TArray<FHitZone> Zones;
+
+	/** Picks the reaction for a hit at AttackPoint on a character at CharacterTrans */
+	void Resolve(const FTransform& CharacterTrans, const FVector& AttackPoint, FHitReaction& OutReaction) const;
+
+	/** Flattens Zones into the lookup, needed again after Zones are changed from code */
+	void BuildLookup();
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	struct FBand
+	{
+		float MinHeight;
+		float CenterHalfWidth;
+		bool bIgnoreBack;
+	};
+
+	/** Bands sorted from the highest to the lowest */
+	TArray<FBand> Bands;
+	/** Band * EHitFacing::MAX + Facing */
+	TArray<FHitReaction> Cells;
+};
@@ -9,5 +9,8 @@ public class LyhActDemo : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "HeadMountedDisplay", "AIModule", "GameplayTasks" });
+
+		// Loading screen during map loads
+		PrivateDependencyModuleNames.AddRange(new string[] { "MoviePlayer", "Slate", "SlateCore" });
 	}
 }
@@ -1,7 +1,141 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "LyhActDemo.h"
+#include "CombatStatsRegistry.h"
+#include "LyhActDemoGameMode.h"
+#include "LyhLoadingScreen.h"
+#include "Containers/Ticker.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/CoreDelegates.h"
 #include "Modules/ModuleManager.h"
+#include "MoviePlayer.h"
+#include "UObject/UObjectGlobals.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, LyhActDemo, "LyhActDemo" );
- 
\ No newline at end of file
+/**
+ * Loads the combat stats once the engine is up and covers map loads: the movie player covers the
+ * blocking part, then the same widget stays on the viewport while the game mode streams the rest in
+ */
+class FLyhActDemoModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		FCoreDelegates::OnPostEngineInit.AddRaw(this, &FLyhActDemoModule::OnPostEngineInit);
+		if (!IsRunningDedicatedServer() && !IsRunningCommandlet())
+		{
+			FCoreUObjectDelegates::PreLoadMap.AddRaw(this, &FLyhActDemoModule::OnPreLoadMap);
+			FCoreUObjectDelegates::PostLoadMapWithWorld.AddRaw(this, &FLyhActDemoModule::OnPostLoadMap);
+		}
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FCoreDelegates::OnPostEngineInit.RemoveAll(this);
+		FCoreUObjectDelegates::PreLoadMap.RemoveAll(this);
+		FCoreUObjectDelegates::PostLoadMapWithWorld.RemoveAll(this);
+		HideLoadingOverlay();
+	}
+private:
+	void OnPostEngineInit()
+	{
+		FCombatStatsRegistry::Get().Initialize();
+	}
+
+	void OnPreLoadMap(const FString& MapName)
+	{
+		HideLoadingOverlay();
+		if (!IsMoviePlayerEnabled() || !GetMoviePlayer())
+		{
+			return;
+		}
+		// The movie player does not tick the world, so it cannot wait for the streaming the game mode
+		// starts; it ends with LoadMap and the overlay takes over
+		FLoadingScreenAttributes LoadingScreen;
+		LoadingScreen.bAutoCompleteWhenLoadingCompletes = true;
+		LoadingScreen.WidgetLoadingScreen = SNew(SLyhLoadingScreen);
+		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
+	}
+
+	void OnPostLoadMap(UWorld* World)
+	{
+		UGameViewportClient* Viewport = World ? World->GetGameViewport() : nullptr;
+		if (!Viewport)
+		{
+			return;
+		}
+		LoadingWorld = World;
+		LoadingViewport = Viewport;
+		LoadingOverlay = SNew(SLyhLoadingScreen);
+		Viewport->AddViewportWidgetContent(LoadingOverlay.ToSharedRef(), 1000);
+		OverlayTicker = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FLyhActDemoModule::TickLoadingOverlay));
+	}
+
+	bool TickLoadingOverlay(float DeltaTime)
+	{
+		if (IsWorldLoading(LoadingWorld.Get()))
+		{
+			return true;
+		}
+		// Returning false removes the ticker
+		OverlayTicker.Reset();
+		HideLoadingOverlay();
+		return false;
+	}
+
+	/** True while the players of World are waiting for ALyhActDemoGameMode to finish loading */
+	static bool IsWorldLoading(const UWorld* World)
+	{
+		if (!World)
+		{
+			return false;
+		}
+		if (const ALyhActDemoGameMode* GameMode = World->GetAuthGameMode<ALyhActDemoGameMode>())
+		{
+			return GameMode->IsLoading() || !GameMode->HasActorBegunPlay();
+		}
+		const AGameStateBase* GameState = World->GetGameState();
+		if (!GameState)
+		{
+			// Clients wait for the game state to arrive, anything else does not use the game mode
+			return World->GetNetMode() == NM_Client;
+		}
+		if (!GameState->GameModeClass || !GameState->GameModeClass->IsChildOf(ALyhActDemoGameMode::StaticClass()))
+		{
+			return false;
+		}
+		// Clients only see the end of the server's loading as their pawn, which it holds back until then
+		const APlayerController* Player = World->GetFirstPlayerController();
+		return !Player || !Player->GetPawn();
+	}
+
+	void HideLoadingOverlay()
+	{
+		if (OverlayTicker.IsValid())
+		{
+			FTicker::GetCoreTicker().RemoveTicker(OverlayTicker);
+			OverlayTicker.Reset();
+		}
+		if (UGameViewportClient* Viewport = LoadingViewport.Get())
+		{
+			if (LoadingOverlay.IsValid())
+			{
+				Viewport->RemoveViewportWidgetContent(LoadingOverlay.ToSharedRef());
+			}
+		}
+		LoadingOverlay.Reset();
+		LoadingViewport.Reset();
+		LoadingWorld.Reset();
+	}
+
+	TSharedPtr<SWidget> LoadingOverlay;
+	TWeakObjectPtr<UGameViewportClient> LoadingViewport;
+	TWeakObjectPtr<UWorld> LoadingWorld;
+	FDelegateHandle OverlayTicker;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FLyhActDemoModule, LyhActDemo, "LyhActDemo" );
+
+DEFINE_LOG_CATEGORY(LogLyhCombat);
@@ -10,9 +10,10 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "Engine/Engine.h"
 #include "Components/SkeletalMeshComponent.h"
-#include "TimerManager.h"
 #include "Kismet/KismetMathLibrary.h"
-#include "ConstructorHelpers.h"
+#include "CombatManager.h"
+#include "CombatProfiling.h"
+#include "Engine/StreamableManager.h"
 
 //////////////////////////////////////////////////////////////////////////
 // ALyhActDemoCharacter
@@ -48,11 +49,15 @@ ALyhActDemoCharacter::ALyhActDemoCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
-	static ConstructorHelpers::FObjectFinder<UDataTable> StateObject(TEXT("/Game/Common/stats"));
-	if (StateObject.Object)
-	{
-		PlayerStates = *StateObject.Object->FindRow<FPlayerStats>(TEXT("Player"), TEXT(""));
-	}
+	// Dodging and defending cost magic for the player
+	DodgeMagicCost = 10;
+	DefenceMagicCost = 5;
+	DodgeRecoverTime = 0.5f;
+	// The player's set is needed first, monsters can wait
+	MontageLoadPriority = FStreamableManager::AsyncLoadHighPriority;
+
+	StatsRow = TEXT("Player");
+
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
 }
@@ -84,26 +89,10 @@ void ALyhActDemoCharacter::SetupPlayerInputComponent(class UInputComponent* Play
 	// VR headset functionality
 	PlayerInputComponent->BindAction("ResetVR", IE_Pressed, this, &ALyhActDemoCharacter::OnResetVR);
 
-	PlayerInputComponent->BindAction("Attack", IE_Pressed, this, &ALyhActDemoCharacter::AttackEnemy);
-	PlayerInputComponent->BindAction("Dodge", IE_Pressed, this, &ALyhActDemoCharacter::Dodge);
-	PlayerInputComponent->BindAction("Defence", IE_Pressed, this, &ALyhActDemoCharacter::Defence_Begin);
-	PlayerInputComponent->BindAction("Defence", IE_Released, this, &ALyhActDemoCharacter::Defence_End);
-}
-
-void ALyhActDemoCharacter::BeginPlay()
-{
-	Super::BeginPlay();
-	MaxMagic = PlayerStates.Magic;
-	if (MaxMagic != 0)
-	{
-		GetWorldTimerManager().SetTimer(RegainHandle, this, &ALyhActDemoCharacter::RegainMagic, 1, true);
-	}
-}
-
-void ALyhActDemoCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
-{
-	Super::EndPlay(EndPlayReason);
-	GetWorldTimerManager().ClearTimer(RegainHandle);
+	PlayerInputComponent->BindAction("Attack", IE_Pressed, this, &ALyhActDemoCharacter::AttackPressed);
+	PlayerInputComponent->BindAction("Dodge", IE_Pressed, this, &ALyhActDemoCharacter::DodgePressed);
+	PlayerInputComponent->BindAction("Defence", IE_Pressed, this, &ALyhActDemoCharacter::DefencePressed);
+	PlayerInputComponent->BindAction("Defence", IE_Released, this, &ALyhActDemoCharacter::DefenceReleased);
 }
 
 void ALyhActDemoCharacter::Jump()
@@ -144,6 +133,10 @@ void ALyhActDemoCharacter::LookUpAtRate(float Rate)
 
 void ALyhActDemoCharacter::MoveForward(float Value)
 {
+	if (FCombatReplayRecorder* Replay = GetReplayRecorder())
+	{
+		Replay->RecordAxis(this, 0, Value);
+	}
 	if ((Controller != NULL) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -158,6 +151,10 @@ void ALyhActDemoCharacter::MoveForward(float Value)
 
 void ALyhActDemoCharacter::MoveRight(float Value)
 {
+	if (FCombatReplayRecorder* Replay = GetReplayRecorder())
+	{
+		Replay->RecordAxis(this, 1, Value);
+	}
 	if (Value == 0)
 	{
 		LeftVector = 0;
@@ -186,274 +183,63 @@ void ALyhActDemoCharacter::MoveRight(float Value)
 	}
 }
 
-void ALyhActDemoCharacter::AttackEnemy()
+void ALyhActDemoCharacter::AttackPressed()
 {
-	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked)
-	{
-		return;
-	}
-	bIsAttacking = true;
-	//GEngine->AddOnScreenDebugMessage(-1, 5, FColor::Red, TEXT("LeftButton"));
-	bCanDamage = 0;
-
-	switch (ComboNum)
-	{
-	case 0:
-		if (Fast_One)
-		{
-			float Deruction = PlayAnimMontage(Fast_One);
-			ComboNum++;
-			GetWorldTimerManager().SetTimer(ComboHandle, this, &ALyhActDemoCharacter::OnAttackComplete, Deruction);
-		}
-		break;
-	case 1:
-		if (Fast_Two)
-		{
-			GetWorldTimerManager().ClearTimer(ComboHandle);
-			float Deruction = PlayAnimMontage(Fast_Two);
-			ComboNum++;
-			GetWorldTimerManager().SetTimer(ComboHandle, this, &ALyhActDemoCharacter::OnAttackComplete, Deruction);
-		}
-		break;
-	case 2:
-		if (Fast_Three)
-		{
-			GetWorldTimerManager().ClearTimer(ComboHandle);
-			PlayAnimMontage(Fast_Three);
-			ComboNum = 0;
-		}
-		break;
-	}
-
+	BufferInput(ECombatInput::Attack);
 }
 
-void ALyhActDemoCharacter::Dodge()
+void ALyhActDemoCharacter::DodgePressed()
 {
-	if (bIsDefencing || GetMovementComponent()->IsFalling() || bIsDodging || PlayerStates.Magic < 10)
-	{
-		return;
-	}
-	PlayerStates.Magic -= 10;
-	GetMesh()->Stop();
-	if (bIsAttacking)
-	{
-		OnAttackComplete();
-		bIsAttacking = false;
-		bCanDamage = 0;
-	}
-	bIsAttacked = false;
-	GetWorldTimerManager().ClearTimer(HurtHandle);
-	bIsDodging = true;
-	float Duration = 0;
-	if (RightVextor > LeftVector)
-	{
-		if (Dodge_Right)
-		{
-			Duration = PlayAnimMontage(Dodge_Right);
-		}
-	}
-	else if (RightVextor < LeftVector)
-	{
-		Duration = PlayAnimMontage(Dodge_Left);
-	}
-	else
-	{
-		Duration = PlayAnimMontage(Dodge_Behind);
-	}
-	GetWorldTimerManager().SetTimer(DodgeHandle, this, &ALyhActDemoCharacter::OnDodgeComplete, Duration - 0.5);
+	BufferInput(ECombatInput::Dodge);
 }
 
-void ALyhActDemoCharacter::OnAttacked(FVector AttackPoint)
+void ALyhActDemoCharacter::DefencePressed()
 {
-	if (bIsDodging)
-	{
-		return;
-	}
-	if (bIsDefencing)
-	{
-		if (Defence_Succeed)
-		{
-			PlayAnimMontage(Defence_Succeed);
-		}
-		Defence_End();
-	}
-	else
-	{
-		if (bIsAttacking)
-		{
-			bIsAttacking = false;
-			bCanDamage = false;
-		}
-		bIsAttacked = true;
-		GetWorldTimerManager().SetTimer(HurtHandle, this, &ALyhActDemoCharacter::OnHurtComplete, 1.5f);
-		GetMesh()->Stop();
-		FTransform CharacterTrans = GetActorTransform();
-		FVector CharacterLocation = CharacterTrans.GetLocation();
-		FVector Direction = UKismetMathLibrary::InverseTransformLocation(CharacterTrans, AttackPoint);;
-		if (AttackPoint.Z > CharacterLocation.Z + 53)
-		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 0)
-				{
-					if (Hit_HeadTop_Left) PlayAnimMontage(Hit_HeadTop_Left);
-				}
-				else
-				{
-					if (Hit_HeadTop_Right) PlayAnimMontage(Hit_HeadTop_Right);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			//扣血值应该为武器的属性,当前武器只有一种,属性固定为10;头部会爆击*2
-			PlayerStates.Blood -= 10*2;
-		}
-		else if (AttackPoint.Z > CharacterLocation.Z + 36)
-		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 0)
-				{
-					if (Hit_HeadDown_Left) PlayAnimMontage(Hit_HeadDown_Left);
-				}
-				else
-				{
-					if (Hit_HeadDown_Right) PlayAnimMontage(Hit_HeadDown_Right);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			PlayerStates.Blood -= 10 * 2;
-		}
-		else if (AttackPoint.Z > CharacterLocation.Z)
-		{
-			if (Direction.Y > 0)
-			{
-				if (Direction.X > 10)
-				{
-					if (Hit_Torso_Left) PlayAnimMontage(Hit_Torso_Left);
-				}
-				else if (Direction.X < -10)
-				{
-					if (Hit_Torso_Right) PlayAnimMontage(Hit_Torso_Right);
-				}
-				else
-				{
-					if (Hit_Torso_Front) PlayAnimMontage(Hit_Torso_Front);
-				}
-			}
-			else
-			{
-				if (Hit_Back) PlayAnimMontage(Hit_Back);
-			}
-			PlayerStates.Blood -= 10;
-		}
-		else
-		{
-			if (Direction.X > 0)
-			{
-				if (Hit_Leg_Left) PlayAnimMontage(Hit_Leg_Left);
-			}
-			else
-			{
-				if (Hit_Leg_Right) PlayAnimMontage(Hit_Leg_Right);
-			}
-			PlayerStates.Blood -= 10;
-		}
-		if (PlayerStates.Blood <= 0)
-		{
-		DeathToReborn();
-		}
-	}
-}
-
-void ALyhActDemoCharacter::OnAttackComplete()
-{
-	GetWorldTimerManager().ClearTimer(ComboHandle);
-	ComboNum = 0;
+	BufferInput(ECombatInput::Defence);
 }
 
-void ALyhActDemoCharacter::OnDodgeComplete()
+void ALyhActDemoCharacter::DefenceReleased()
 {
-	bIsDodging = false;
-	GetWorldTimerManager().ClearTimer(DodgeHandle);
+	ReleaseDefence();
 }
 
-void ALyhActDemoCharacter::Defence_Begin()
+void ALyhActDemoCharacter::OnDefenceBegin()
 {
-	if (bIsAttacking || GetMovementComponent()->IsFalling() || bIsDodging || bIsDefencing || bIsAttacked || PlayerStates.Magic < 5)
-	{
-		return;
-	}
-	PlayerStates.Magic -= 5;
 	PlayerStates.MagicRegain = 0;
-	bIsDefencing = true;
-	if (Defence_Start)
-	{
-		PlayAnimMontage(Defence_Start);
-	}
-	GetCharacterMovement()->MaxWalkSpeed = 200;
 }
 
-void ALyhActDemoCharacter::Defence_End()
+void ALyhActDemoCharacter::OnDefenceEnd()
 {
-	bIsDefencing = false;
 	PlayerStates.MagicRegain = 1;
-	GetCharacterMovement()->MaxWalkSpeed = 600;
 }
 
-void ALyhActDemoCharacter::OnBounced()
+ACharacter* ALyhActDemoCharacter::CheckAI(float RotationRate, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime)
 {
-	GetMesh()->Stop();
-	bIsAttacking = false;
-	if (Hit_Torso_Front)
+	COMBAT_COUNTER_SCOPE(CheckAI);
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!Manager)
 	{
-		PlayAnimMontage(Hit_Torso_Front);
+		return nullptr;
 	}
-	OnAttackComplete();
-}
-
-void ALyhActDemoCharacter::OnHurtComplete()
-{
-	bIsAttacked = false;
-	GetWorldTimerManager().ClearTimer(HurtHandle);
-}
+	FVector Start = GetActorLocation();
 
-void ALyhActDemoCharacter::RegainMagic()
-{
-	if (PlayerStates.Magic < MaxMagic)
+	FCombatTargetQuery Query;
+	Query.Origin = Start;
+	Query.Forward = GetActorForwardVector();
+	Query.Radius = 1000;
+	Query.HalfAngle = RotationRate;
+	Query.MaxCount = 1;
+	Query.ActorsToIgnore = &ActorsToIgnore;
+	Query.IgnoreActor = bIgnoreSelf ? this : nullptr;
+	TArray<FCombatTarget> Targets;
+	if (Manager->GetTargetGrid().Query(Query, Targets) == 0)
 	{
-		PlayerStates.Magic += PlayerStates.MagicRegain;
+		return nullptr;
 	}
-}
 
-ACharacter* ALyhActDemoCharacter::CheckAI(float RotationRate, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime)
-{
-	TArray<FHitResult> OutHits;
+	//检测与最近的目标之间有没有障碍物
 	FHitResult OutHit;
-	FVector Start = GetActorLocation();
-	FVector End = Start + FVector(0, 0, 15);
-
-	UKismetSystemLibrary::SphereTraceMultiForObjects(this, Start, End, 1000, ObjectTypes, false, ActorsToIgnore, DrawDebugType, OutHits, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
-	if (OutHits.Num() > 0)
-	{
-		for (TArray<FHitResult>::TIterator It = OutHits.CreateIterator(); It; ++It)
-		{
-			if (FMath::Abs(UKismetMathLibrary::FindLookAtRotation(Start, It->GetActor()->GetActorLocation()).Yaw - GetActorRotation().Yaw) >= RotationRate)
-			{
-				continue;
-			}
-			//检测与玩家之间有没有障碍物
-			UKismetSystemLibrary::LineTraceSingle(this, Start, It->GetActor()->GetActorLocation(), ETraceTypeQuery::TraceTypeQuery2, 0, ActorsToIgnore, DrawDebugType, OutHit, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
-			if (ACharacter* Target = Cast<ACharacter>(OutHit.GetActor()))
-			{
-				return Target;
-			}
-		}
-	}
-	return nullptr;
+	COMBAT_COUNTER_INC(LockOnTraces);
+	UKismetSystemLibrary::LineTraceSingle(this, Start, Targets[0].Character->GetActorLocation(), ETraceTypeQuery::TraceTypeQuery2, 0, ActorsToIgnore, DrawDebugType, OutHit, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
+	return Cast<ACharacter>(OutHit.GetActor());
 }
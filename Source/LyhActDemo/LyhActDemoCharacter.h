@@ -3,13 +3,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Character.h"
+#include "CombatCharacter.h"
 #include "Kismet/KismetSystemLibrary.h"
 #include "PlayerStats.h"
 #include "LyhActDemoCharacter.generated.h"
 
 UCLASS(config=Game)
-class ALyhActDemoCharacter : public ACharacter
+class ALyhActDemoCharacter : public ACombatCharacter
 {
 	GENERATED_BODY()
 
@@ -33,8 +33,6 @@ public:
 	float BaseLookUpRate;
 
 protected:
-	virtual void BeginPlay() override;
-	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Jump() override;
 
 	/** Resets HMD orientation in VR. */
@@ -64,6 +62,15 @@ protected:
 	/** Handler for when a touch input stops. */
 	void TouchStopped(ETouchIndex::Type FingerIndex, FVector Location);
 
+	/** Combat presses go through the input buffer */
+	void AttackPressed();
+	void DodgePressed();
+	void DefencePressed();
+	void DefenceReleased();
+
+	virtual void OnDefenceBegin() override;
+	virtual void OnDefenceEnd() override;
+
 protected:
 	// APawn interface
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
@@ -76,90 +83,10 @@ public:
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
 public:
-	int32 ComboNum = 0;
-	int8 LeftVector = 0;
-	int8 RightVextor = 0;
-	int32 MaxMagic;
 	UPROPERTY(BlueprintReadWrite)
 	FPlayerStats PlayerStates;
-	/***********************state********************/
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bIsDodging = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bIsDefencing = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bIsDeath = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bIsAttacking = false;
-	bool bIsAttacked = false;
-	UPROPERTY(BlueprintReadWrite, Category = "State")
-	bool bCanDamage = 0;
-	/***********************state********************/
-
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Fast_One;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Fast_Two;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Fast_Three;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Back;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_HeadTop_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_HeadTop_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_HeadDown_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_HeadDown_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Torso_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Torso_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Torso_Front;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Leg_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Hit_Leg_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Dodge_Left;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Dodge_Right;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Dodge_Behind;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Defence_Start;
-	UPROPERTY(EditDefaultsOnly, Category = "Anim")
-	UAnimMontage* Defence_Succeed;
-
-	FTimerHandle ComboHandle;
-	FTimerHandle DodgeHandle;
-	FTimerHandle HurtHandle;
-	FTimerHandle RegainHandle;
 public:
-	UFUNCTION(BlueprintCallable)
-	void AttackEnemy();
-	void Dodge();
-	UFUNCTION(BlueprintCallable)
-	void OnAttacked(FVector AttackPoint);
-	UFUNCTION()
-	void OnAttackComplete();
-	UFUNCTION()
-	void OnDodgeComplete();
-	UFUNCTION()
-	void Defence_Begin();
-	UFUNCTION()
-	void Defence_End();
-	UFUNCTION(BlueprintCallable)
-	void OnBounced();
-	UFUNCTION()
-	void OnHurtComplete();
-	UFUNCTION()
-	void RegainMagic();
-
-	UFUNCTION(BlueprintImplementableEvent)
-	void DeathToReborn();
+	virtual FPlayerStats& GetCombatStats() override { return PlayerStates; }
 	UFUNCTION(BlueprintCallable)
 	ACharacter* CheckAI(float RotationRate, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime);
 
@@ -1,15 +1,165 @@
 // Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
 
 #include "LyhActDemoGameMode.h"
+#include "LyhActDemo.h"
 #include "LyhActDemoCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "AICharacter.h"
+#include "CombatMontageSet.h"
+#include "Engine/AssetManager.h"
+#include "Engine/LatentActionManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Sound/SoundBase.h"
 
 ALyhActDemoGameMode::ALyhActDemoGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/Common/ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// Our Blueprinted character is streamed in by InitGame instead of loading with the game mode
+	DefaultPawnClass = ALyhActDemoCharacter::StaticClass();
+	PlayerPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/Common/ThirdPersonCharacter.ThirdPersonCharacter_C")));
+	MonsterClasses.Add(TSoftClassPtr<AAICharacter>(FSoftObjectPath(TEXT("/Game/AI/BP_AICharacter.BP_AICharacter_C"))));
+	Sounds.Add(TSoftObjectPtr<USoundBase>(FSoftObjectPath(TEXT("/Game/Sounds/Character_Att.Character_Att"))));
+	Sounds.Add(TSoftObjectPtr<USoundBase>(FSoftObjectPath(TEXT("/Game/Sounds/Stab_Tone01.Stab_Tone01"))));
+	PrewarmMonstersPerClass = 0;
+}
+
+void ALyhActDemoGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	TArray<FSoftObjectPath> Paths;
+	if (!PlayerPawnClass.IsNull())
+	{
+		Paths.Add(PlayerPawnClass.ToSoftObjectPath());
+	}
+	for (const TSoftClassPtr<AAICharacter>& MonsterClass : MonsterClasses)
+	{
+		if (!MonsterClass.IsNull())
+		{
+			Paths.Add(MonsterClass.ToSoftObjectPath());
+		}
+	}
+	for (const TSoftObjectPtr<UCombatMontageSet>& MontageSet : MontageSets)
+	{
+		if (!MontageSet.IsNull())
+		{
+			Paths.Add(MontageSet.ToSoftObjectPath());
+		}
+	}
+	for (const TSoftObjectPtr<USoundBase>& Sound : Sounds)
+	{
+		if (!Sound.IsNull())
+		{
+			Paths.Add(Sound.ToSoftObjectPath());
+		}
+	}
+	if (Paths.Num() == 0)
+	{
+		bAssetsLoaded = true;
+		return;
+	}
+	// Still inside the map load, the request starts behind the loading screen. The handle keeps
+	// everything loaded for as long as the game mode lives
+	CombatAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &ALyhActDemoGameMode::OnCombatAssetsLoaded), FStreamableManager::AsyncLoadHighPriority);
+	if (!CombatAssetsHandle.IsValid())
+	{
+		OnCombatAssetsLoaded();
+	}
+}
+
+void ALyhActDemoGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+	for (const FName& LevelName : StartupLevels)
+	{
+		PendingLevels++;
+		LoadLevel(LevelName, true, true);
+	}
+	TryFinishLoading();
+}
+
+void ALyhActDemoGameMode::StreamArenaLevel(FName LevelName, bool bMakeVisible)
+{
+	LoadLevel(LevelName, bMakeVisible, false);
+}
+
+void ALyhActDemoGameMode::LoadLevel(FName LevelName, bool bMakeVisible, bool bStartup)
+{
+	FLatentActionInfo LatentInfo;
+	if (bStartup)
+	{
+		LatentInfo.CallbackTarget = this;
+		LatentInfo.ExecutionFunction = GET_FUNCTION_NAME_CHECKED(ALyhActDemoGameMode, OnStartupLevelLoaded);
+		LatentInfo.Linkage = 0;
+	}
+	// Pending latent actions with the same id on the same object would be merged
+	LatentInfo.UUID = NextLatentId++;
+	UGameplayStatics::LoadStreamLevel(this, LevelName, bMakeVisible, false, LatentInfo);
+}
+
+void ALyhActDemoGameMode::UnloadArenaLevel(FName LevelName)
+{
+	FLatentActionInfo LatentInfo;
+	LatentInfo.UUID = NextLatentId++;
+	UGameplayStatics::UnloadStreamLevel(this, LevelName, LatentInfo);
+}
+
+void ALyhActDemoGameMode::HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer)
+{
+	if (IsLoading())
+	{
+		// Spawned with the real pawn class once loading is done
+		PendingPlayers.AddUnique(NewPlayer);
+		return;
+	}
+	Super::HandleStartingNewPlayer_Implementation(NewPlayer);
+}
+
+void ALyhActDemoGameMode::OnCombatAssetsLoaded()
+{
+	if (UClass* PawnClass = PlayerPawnClass.Get())
+	{
+		DefaultPawnClass = PawnClass;
+	}
+	else if (!PlayerPawnClass.IsNull())
+	{
+		UE_LOG(LogLyhCombat, Warning, TEXT("Could not load the player pawn %s, players get %s"), *PlayerPawnClass.ToString(), *GetNameSafe(DefaultPawnClass));
+	}
+	if (PrewarmMonstersPerClass > 0)
+	{
+		for (const TSoftClassPtr<AAICharacter>& MonsterClass : MonsterClasses)
+		{
+			if (UClass* Class = MonsterClass.Get())
+			{
+				AAICharacter::PrewarmMonsterPool(this, Class, PrewarmMonstersPerClass);
+			}
+		}
+	}
+	bAssetsLoaded = true;
+	TryFinishLoading();
+}
+
+void ALyhActDemoGameMode::OnStartupLevelLoaded()
+{
+	PendingLevels = FMath::Max(PendingLevels - 1, 0);
+	TryFinishLoading();
+}
+
+void ALyhActDemoGameMode::TryFinishLoading()
+{
+	if (bLoadingFinished || IsLoading() || !HasActorBegunPlay())
+	{
+		return;
+	}
+	bLoadingFinished = true;
+	TArray<APlayerController*> Players = MoveTemp(PendingPlayers);
+	PendingPlayers.Reset();
+	for (APlayerController* Player : Players)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		if (Player && !Player->IsPendingKill())
+		{
+			Super::HandleStartingNewPlayer_Implementation(Player);
+		}
 	}
+	OnLoadingFinished();
 }
@@ -4,16 +4,78 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "Engine/StreamableManager.h"
 #include "LyhActDemoGameMode.generated.h"
 
-UCLASS(minimalapi)
+class AAICharacter;
+class UCombatMontageSet;
+class USoundBase;
+
+/**
+ * Loads the player pawn, the monster Blueprints, montage sets and sounds in the background once the
+ * map is in, together with the arena sub-levels. Players join right away but only get their pawn
+ * when everything has arrived, so nothing is loaded synchronously in the middle of a fight. The game
+ * module keeps its loading screen on the viewport until then.
+ */
+UCLASS(minimalapi, config = Game)
 class ALyhActDemoGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 
 public:
 	ALyhActDemoGameMode();
-};
 
+	/** Pawn of the players, replaces DefaultPawnClass once loaded */
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	TSoftClassPtr<APawn> PlayerPawnClass;
+
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	TArray<TSoftClassPtr<AAICharacter>> MonsterClasses;
+
+	/** Parked monsters spawned per monster class once it is loaded, so the first wave does not spawn any */
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	int32 PrewarmMonstersPerClass;
+
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	TArray<TSoftObjectPtr<UCombatMontageSet>> MontageSets;
 
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	TArray<TSoftObjectPtr<USoundBase>> Sounds;
 
+	/** Sub-levels of the arena streamed in and shown before the players spawn */
+	UPROPERTY(config, EditDefaultsOnly, Category = "Loading")
+	TArray<FName> StartupLevels;
+
+	/** True until the combat assets and startup levels are in */
+	UFUNCTION(BlueprintPure, Category = "Loading")
+	bool IsLoading() const { return !bAssetsLoaded || PendingLevels > 0; }
+
+	/** Streams a sub-level of a larger arena in without blocking, e.g. when the fight moves on */
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+	void StreamArenaLevel(FName LevelName, bool bMakeVisible);
+	UFUNCTION(BlueprintCallable, Category = "Loading")
+	void UnloadArenaLevel(FName LevelName);
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void BeginPlay() override;
+	virtual void HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer) override;
+protected:
+	/** Everything is in, players can have their pawns. Called on the server only */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Loading")
+	void OnLoadingFinished();
+private:
+	void OnCombatAssetsLoaded();
+	void LoadLevel(FName LevelName, bool bMakeVisible, bool bStartup);
+	UFUNCTION()
+	void OnStartupLevelLoaded();
+	/** Starts the players that joined while loading once nothing is pending any more */
+	void TryFinishLoading();
+
+	TSharedPtr<FStreamableHandle> CombatAssetsHandle;
+	bool bAssetsLoaded = false;
+	bool bLoadingFinished = false;
+	int32 PendingLevels = 0;
+	int32 NextLatentId = 0;
+	UPROPERTY()
+	TArray<APlayerController*> PendingPlayers;
+};
@@ -4,28 +4,150 @@
 #include "Engine/Engine.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "LyhActDemoCharacter.h"
+#include "CombatManager.h"
+#include "CombatProfiling.h"
+#include "Engine/World.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "Blueprint/AIBlueprintHelperLibrary.h"
+#include "AIController.h"
 
 
 
+ULyhBTService::ULyhBTService(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	EnemyKey.AddObjectFilter(this, GET_MEMBER_NAME_CHECKED(ULyhBTService, EnemyKey), ALyhActDemoCharacter::StaticClass());
+}
 
+void ULyhBTService::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	Super::OnBecomeRelevant(OwnerComp, NodeMemory);
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (bUseScheduler && Manager && AIOwner)
+	{
+		Manager->GetPerceptionScheduler().Register(this, AIOwner->GetPawn(), Manager->GetRandom());
+	}
+}
 
-ALyhActDemoCharacter* ULyhBTService::CheckEnemy(const FVector Start, const FVector End, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, ETraceTypeQuery TraceChannel, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime)
+void ULyhBTService::OnCeaseRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
 {
-	TArray<FHitResult> OutHits;
-	FHitResult OutHit;
-	//检测玩家
-	UKismetSystemLibrary::SphereTraceMultiForObjects(this, Start, End, Radius, ObjectTypes, bTraceComplex, ActorsToIgnore, DrawDebugType, OutHits, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
-	if (OutHits.Num() > 0)
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->GetPerceptionScheduler().Unregister(this);
+	}
+	Super::OnCeaseRelevant(OwnerComp, NodeMemory);
+}
+
+bool ULyhBTService::TakePerceptionTurn()
+{
+	if (PerceptionSlot == INDEX_NONE)
 	{
-		for (TArray<FHitResult>::TIterator It = OutHits.CreateIterator(); It; ++It)
+		return true;
+	}
+	ACombatManager* Manager = ACombatManager::Get(this);
+	return !Manager || Manager->GetPerceptionScheduler().ConsumeGrant(this);
+}
+
+void ULyhBTService::ReportPerceptionCost(uint32 StartCycles)
+{
+	if (PerceptionSlot != INDEX_NONE)
+	{
+		if (ACombatManager* Manager = ACombatManager::Get(this))
 		{
-			//检测与玩家之间有没有障碍物
-			UKismetSystemLibrary::LineTraceSingle(this, Start, It->GetActor()->GetActorLocation(), TraceChannel, 0, ActorsToIgnore, DrawDebugType, OutHit, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
-			if (ALyhActDemoCharacter* Target = Cast<ALyhActDemoCharacter>(OutHit.GetActor()))
-			{
-				return Target;
-			}
+			Manager->GetPerceptionScheduler().ReportCost(FPlatformTime::ToSeconds(FPlatformTime::Cycles() - StartCycles));
 		}
 	}
-	return nullptr;
+}
+
+ALyhActDemoCharacter* ULyhBTService::CheckEnemy(const FVector Start, const FVector End, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, ETraceTypeQuery TraceChannel, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime)
+{
+	COMBAT_COUNTER_SCOPE(CheckEnemy);
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!Manager)
+	{
+		return nullptr;
+	}
+	if (!TakePerceptionTurn())
+	{
+		return CachedEnemy.Get();
+	}
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	//检测玩家
+	FCombatTargetQuery Query;
+	Query.Origin = Start;
+	Query.Radius = Radius;
+	Query.MaxCount = 1;
+	Query.TargetClass = ALyhActDemoCharacter::StaticClass();
+	Query.ActorsToIgnore = &ActorsToIgnore;
+	TArray<FCombatTarget> Targets;
+	CachedEnemy = nullptr;
+	if (Manager->GetTargetGrid().Query(Query, Targets) > 0)
+	{
+		//检测与玩家之间有没有障碍物
+		FHitResult OutHit;
+		COMBAT_COUNTER_INC(Traces);
+		UKismetSystemLibrary::LineTraceSingle(this, Start, Targets[0].Character->GetActorLocation(), TraceChannel, 0, ActorsToIgnore, DrawDebugType, OutHit, bIgnoreSelf, TraceColor, TraceHitColor, DrawTime);
+		CachedEnemy = Cast<ALyhActDemoCharacter>(OutHit.GetActor());
+	}
+	CachedTime = GetWorld()->GetTimeSeconds();
+	ReportPerceptionCost(StartCycles);
+	return CachedEnemy.Get();
+}
+
+ALyhActDemoCharacter* ULyhBTService::CheckEnemyAsync(const FVector Start, float Radius, ETraceTypeQuery TraceChannel, const TArray<AActor*>& ActorsToIgnore)
+{
+	COMBAT_COUNTER_SCOPE(CheckEnemy);
+	UWorld* World = GetWorld();
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!World || !Manager || bTracePending || World->GetTimeSeconds() - CachedTime < MaxResultAge || !TakePerceptionTurn())
+	{
+		return CachedEnemy.Get();
+	}
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	//检测玩家
+	FCombatTargetQuery Query;
+	Query.Origin = Start;
+	Query.Radius = Radius;
+	Query.MaxCount = 1;
+	Query.TargetClass = ALyhActDemoCharacter::StaticClass();
+	Query.ActorsToIgnore = &ActorsToIgnore;
+	TArray<FCombatTarget> Targets;
+	if (Manager->GetTargetGrid().Query(Query, Targets) == 0)
+	{
+		FTraceDatum NoTarget;
+		OnLineOfSightTraced(FTraceHandle(), NoTarget);
+		ReportPerceptionCost(StartCycles);
+		return nullptr;
+	}
+
+	//检测与玩家之间有没有障碍物, 结果下一帧写入黑板
+	FCollisionQueryParams Params(FName(TEXT("LyhCheckEnemy")), false);
+	Params.AddIgnoredActors(ActorsToIgnore);
+	if (AIOwner)
+	{
+		Params.AddIgnoredActor(AIOwner->GetPawn());
+	}
+	if (!LineOfSightDelegate.IsBound())
+	{
+		LineOfSightDelegate.BindUObject(this, &ULyhBTService::OnLineOfSightTraced);
+	}
+	bTracePending = true;
+	COMBAT_COUNTER_INC(Traces);
+	World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, Targets[0].Character->GetActorLocation(), UEngineTypes::ConvertToCollisionChannel(TraceChannel), Params, FCollisionResponseParams::DefaultResponseParam, &LineOfSightDelegate);
+	ReportPerceptionCost(StartCycles);
+	return CachedEnemy.Get();
+}
+
+void ULyhBTService::OnLineOfSightTraced(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	bTracePending = false;
+	CachedTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	CachedEnemy = TraceDatum.OutHits.Num() > 0 ? Cast<ALyhActDemoCharacter>(TraceDatum.OutHits[0].GetActor()) : nullptr;
+
+	if (UBlackboardComponent* Blackboard = UAIBlueprintHelperLibrary::GetBlackboard(AIOwner))
+	{
+		Blackboard->SetValueAsObject(EnemyKey.SelectedKeyName, CachedEnemy.Get());
+	}
 }
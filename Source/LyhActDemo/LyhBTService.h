@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "BehaviorTree/Services/BTService_BlueprintBase.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "BehaviorTree/BehaviorTreeTypes.h"
+#include "WorldCollision.h"
 #include "LyhBTService.generated.h"
 
 /**
@@ -15,8 +17,48 @@ class LYHACTDEMO_API ULyhBTService : public UBTService_BlueprintBase
 {
 	GENERATED_BODY()
 public:
+	ULyhBTService(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
 	UFUNCTION(BlueprintCallable)
 	class ALyhActDemoCharacter* CheckEnemy(const FVector Start, const FVector End, float Radius, const TArray<TEnumAsByte<EObjectTypeQuery> > & ObjectTypes, bool bTraceComplex, ETraceTypeQuery TraceChannel, const TArray<AActor*>& ActorsToIgnore, EDrawDebugTrace::Type DrawDebugType, bool bIgnoreSelf, FLinearColor TraceColor, FLinearColor TraceHitColor, float DrawTime);
-	
-	
+
+	/**
+	 * Non blocking CheckEnemy: returns the last known enemy and, once it is older than MaxResultAge, starts an async
+	 * line of sight trace. The trace result is written to EnemyKey on the blackboard when it arrives next frame.
+	 */
+	UFUNCTION(BlueprintCallable)
+	class ALyhActDemoCharacter* CheckEnemyAsync(const FVector Start, float Radius, ETraceTypeQuery TraceChannel, const TArray<AActor*>& ActorsToIgnore);
+
+	/** Blackboard key that receives the enemy found by CheckEnemyAsync */
+	UPROPERTY(EditAnywhere, Category = "Perception")
+	FBlackboardKeySelector EnemyKey;
+
+	/** How long a CheckEnemyAsync result is reused before tracing again, in seconds */
+	UPROPERTY(EditAnywhere, Category = "Perception")
+	float MaxResultAge = 0.3f;
+
+	/** Hand the checks to the perception scheduler of the world; a granted check runs on the next tick of the service */
+	UPROPERTY(EditAnywhere, Category = "Perception")
+	bool bUseScheduler = true;
+
+	bool HasEnemy() const { return CachedEnemy.IsValid(); }
+
+protected:
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+	virtual void OnCeaseRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+private:
+	friend class FPerceptionScheduler;
+
+	/** False when the scheduler has not given this monster a turn this frame */
+	bool TakePerceptionTurn();
+	void ReportPerceptionCost(uint32 StartCycles);
+
+	int32 PerceptionSlot = INDEX_NONE;
+	void OnLineOfSightTraced(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	bool bTracePending = false;
+	FTraceDelegate LineOfSightDelegate;
+	TWeakObjectPtr<class ALyhActDemoCharacter> CachedEnemy;
+	float CachedTime = -BIG_NUMBER;
 };
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LyhLoadingScreen.h"
+#include "Styling/CoreStyle.h"
+#include "Widgets/Images/SThrobber.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Text/STextBlock.h"
+
+#define LOCTEXT_NAMESPACE "LyhLoadingScreen"
+
+ULyhLoadingScreenSettings::ULyhLoadingScreenSettings()
+{
+	CategoryName = TEXT("Game");
+	LoadingText = LOCTEXT("Loading", "Loading...");
+	BackgroundColor = FLinearColor::Black;
+	bShowThrobber = true;
+}
+
+void SLyhLoadingScreen::Construct(const FArguments& InArgs)
+{
+	const ULyhLoadingScreenSettings* Settings = GetDefault<ULyhLoadingScreenSettings>();
+	TSharedRef<SHorizontalBox> Status = SNew(SHorizontalBox)
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.VAlign(VAlign_Center)
+		[
+			SNew(STextBlock)
+			.Text(Settings->LoadingText)
+			.Font(FCoreStyle::GetDefaultFontStyle("Regular", 18))
+		];
+	if (Settings->bShowThrobber)
+	{
+		Status->AddSlot()
+			.AutoWidth()
+			.VAlign(VAlign_Center)
+			.Padding(16.f, 0.f, 0.f, 0.f)
+			[
+				SNew(SThrobber)
+			];
+	}
+
+	ChildSlot
+	[
+		SNew(SBorder)
+		.BorderImage(FCoreStyle::Get().GetBrush("WhiteBrush"))
+		.BorderBackgroundColor(Settings->BackgroundColor)
+		.HAlign(HAlign_Right)
+		.VAlign(VAlign_Bottom)
+		.Padding(FMargin(48.f))
+		[
+			Status
+		]
+	];
+}
+
+#undef LOCTEXT_NAMESPACE
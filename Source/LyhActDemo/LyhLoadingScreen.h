@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "Widgets/DeclarativeSyntaxSupport.h"
+#include "Widgets/SCompoundWidget.h"
+#include "LyhLoadingScreen.generated.h"
+
+/** Look of the loading screen, under Project Settings > Game > Loading Screen */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Loading Screen"))
+class LYHACTDEMO_API ULyhLoadingScreenSettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+public:
+	ULyhLoadingScreenSettings();
+
+	UPROPERTY(config, EditAnywhere, Category = "Loading Screen")
+	FText LoadingText;
+
+	UPROPERTY(config, EditAnywhere, Category = "Loading Screen")
+	FLinearColor BackgroundColor;
+
+	UPROPERTY(config, EditAnywhere, Category = "Loading Screen")
+	bool bShowThrobber;
+};
+
+/**
+ * Loading screen of the game, shown by the movie player during the blocking part of a map load and
+ * on the viewport while the game mode streams the rest in
+ */
+class LYHACTDEMO_API SLyhLoadingScreen : public SCompoundWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SLyhLoadingScreen) {}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MonsterAIController.h"
+#include "CombatManager.h"
+#include "Navigation/CrowdFollowingComponent.h"
+
+AMonsterAIController::AMonsterAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCrowdFollowingComponent>(TEXT("PathFollowingComponent")))
+{
+	SeparationWeight = 2.f;
+}
+
+void AMonsterAIController::BeginPlay()
+{
+	Super::BeginPlay();
+	if (UCrowdFollowingComponent* CrowdFollowing = Cast<UCrowdFollowingComponent>(GetPathFollowingComponent()))
+	{
+		CrowdFollowing->SetCrowdSeparation(true);
+		CrowdFollowing->SetCrowdSeparationWeight(SeparationWeight);
+		CrowdFollowing->SetCrowdAvoidanceQuality(ECrowdAvoidanceQuality::Medium);
+		// Crowd agent slots are handed out by the crowd budget, not by spawn order
+		CrowdFollowing->SetCrowdSimulationState(ECrowdSimulationState::Disabled);
+	}
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->GetCrowd().Register(this);
+	}
+}
+
+void AMonsterAIController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->GetCrowd().Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AMonsterAIController::SetCrowdAgentActive(bool bActive)
+{
+	UCrowdFollowingComponent* CrowdFollowing = Cast<UCrowdFollowingComponent>(GetPathFollowingComponent());
+	if (!CrowdFollowing)
+	{
+		return true;
+	}
+	// Obstacle only agents would still take detour agent slots, monsters outside the budget leave the crowd.
+	// The state does not change while a move is in progress
+	CrowdFollowing->SetCrowdSimulationState(bActive ? ECrowdSimulationState::Enabled : ECrowdSimulationState::Disabled);
+	return CrowdFollowing->IsCrowdSimulationEnabled() == bActive;
+}
+
+FVector AMonsterAIController::GetSurroundLocation(AActor* Target)
+{
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!Target || !Manager)
+	{
+		return Target ? Target->GetActorLocation() : FVector::ZeroVector;
+	}
+	return Manager->GetCrowd().ClaimSlot(this, Target);
+}
+
+EPathFollowingRequestResult::Type AMonsterAIController::MoveToSurroundSlot(AActor* Target, float AcceptanceRadius)
+{
+	if (!Target)
+	{
+		return EPathFollowingRequestResult::Failed;
+	}
+	return MoveToLocation(GetSurroundLocation(Target), AcceptanceRadius);
+}
+
+void AMonsterAIController::ReleaseSurroundSlot()
+{
+	if (ACombatManager* Manager = ACombatManager::Get(this))
+	{
+		Manager->GetCrowd().ReleaseSlot(this);
+	}
+}
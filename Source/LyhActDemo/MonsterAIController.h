@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "MonsterAIController.generated.h"
+
+/**
+ * Controller of the monsters. Paths with detour crowd avoidance while the combat manager's crowd
+ * budget allows it, and spreads the monsters chasing one target over slots around it.
+ */
+UCLASS(config = Game)
+class LYHACTDEMO_API AMonsterAIController : public AAIController
+{
+	GENERATED_BODY()
+public:
+	AMonsterAIController(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+	/** How strongly crowd agents keep apart from each other */
+	UPROPERTY(EditDefaultsOnly, Category = "Crowd")
+	float SeparationWeight;
+
+	/** Where this monster should stand around Target, claiming a free slot if it has none there yet */
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	FVector GetSurroundLocation(AActor* Target);
+
+	/** Moves to this monster's slot around Target */
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	EPathFollowingRequestResult::Type MoveToSurroundSlot(AActor* Target, float AcceptanceRadius = 50.f);
+
+	/** Gives the slot back, e.g. when the target changes or the monster dies */
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	void ReleaseSurroundSlot();
+
+	/** Called by the crowd budget: full avoidance, or no crowd agent at all. False while the
+	 *  switch cannot happen, e.g. during a move */
+	bool SetCrowdAgentActive(bool bActive);
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MonsterPool.h"
+#include "AICharacter.h"
+#include "Engine/World.h"
+
+AAICharacter* FMonsterPool::Spawn(UWorld* World, UClass* Class, const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnInfo;
+	SpawnInfo.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	return World->SpawnActor<AAICharacter>(Class, Transform, SpawnInfo);
+}
+
+AAICharacter* FMonsterPool::Acquire(UWorld* World, UClass* Class, const FTransform& Transform)
+{
+	if (!World || !Class)
+	{
+		return nullptr;
+	}
+	if (TArray<TWeakObjectPtr<AAICharacter>>* Free = FreeMonsters.Find(Class))
+	{
+		while (Free->Num() > 0)
+		{
+			AAICharacter* Monster = Free->Pop(false).Get();
+			if (Monster && !Monster->IsPendingKill())
+			{
+				Monster->Reactivate(Transform);
+				return Monster;
+			}
+		}
+	}
+	return Spawn(World, Class, Transform);
+}
+
+void FMonsterPool::Release(AAICharacter* Monster)
+{
+	if (!Monster || Monster->IsPooled())
+	{
+		return;
+	}
+	Monster->Deactivate();
+	FreeMonsters.FindOrAdd(Monster->GetClass()).Add(Monster);
+}
+
+void FMonsterPool::Prewarm(UWorld* World, UClass* Class, int32 Count)
+{
+	if (!World || !Class)
+	{
+		return;
+	}
+	// Park them far below the arena until they are needed
+	const FTransform Hidden(FVector(0.f, 0.f, -100000.f));
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		if (AAICharacter* Monster = Spawn(World, Class, Hidden))
+		{
+			Release(Monster);
+		}
+	}
+}
+
+int32 FMonsterPool::NumFree(UClass* Class) const
+{
+	const TArray<TWeakObjectPtr<AAICharacter>>* Free = FreeMonsters.Find(Class);
+	return Free ? Free->Num() : 0;
+}
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AAICharacter;
+class UWorld;
+
+/**
+ * Dead monsters are parked here instead of being destroyed and reused by the next spawn of the
+ * same class, so waves do not pay for spawning skeletal meshes and AI controllers.
+ */
+class LYHACTDEMO_API FMonsterPool
+{
+public:
+	/** Reactivates a parked monster of Class at Transform, or spawns a new one if none is free */
+	AAICharacter* Acquire(UWorld* World, UClass* Class, const FTransform& Transform);
+	/** Deactivates Monster and parks it */
+	void Release(AAICharacter* Monster);
+	/** Spawns Count parked monsters of Class ahead of a wave */
+	void Prewarm(UWorld* World, UClass* Class, int32 Count);
+	int32 NumFree(UClass* Class) const;
+	void Reset() { FreeMonsters.Reset(); }
+private:
+	AAICharacter* Spawn(UWorld* World, UClass* Class, const FTransform& Transform);
+
+	TMap<UClass*, TArray<TWeakObjectPtr<AAICharacter>>> FreeMonsters;
+};
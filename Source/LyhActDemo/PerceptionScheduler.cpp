@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PerceptionScheduler.h"
+#include "LyhBTService.h"
+#include "CombatCharacter.h"
+#include "GameFramework/Pawn.h"
+
+namespace PerceptionScheduler
+{
+	/** Monsters farther than this from every player get the base rate */
+	const float FarDistance = 5000.f;
+}
+
+void FPerceptionScheduler::Register(ULyhBTService* Service, APawn* Pawn, FRandomStream& Random)
+{
+	if (!Service || Service->PerceptionSlot != INDEX_NONE)
+	{
+		return;
+	}
+	FEntry Entry;
+	Entry.Service = Service;
+	Entry.Pawn = Pawn;
+	// New monsters start with a random head start so a wave spawned together does not check in the same frame
+	Entry.Urgency = Random.FRand();
+	Entry.GrantFrame = INDEX_NONE;
+	Service->PerceptionSlot = Entries.Add(Entry);
+}
+
+void FPerceptionScheduler::Unregister(ULyhBTService* Service)
+{
+	if (Service && Entries.IsValidIndex(Service->PerceptionSlot) && Entries[Service->PerceptionSlot].Service == Service)
+	{
+		RemoveEntry(Service->PerceptionSlot);
+	}
+}
+
+void FPerceptionScheduler::RemoveEntry(int32 Index)
+{
+	if (ULyhBTService* Service = Entries[Index].Service.Get())
+	{
+		Service->PerceptionSlot = INDEX_NONE;
+	}
+	if (Entries[Index].GrantFrame != INDEX_NONE)
+	{
+		Outstanding--;
+	}
+	Entries.RemoveAtSwap(Index, 1, false);
+	if (Entries.IsValidIndex(Index))
+	{
+		if (ULyhBTService* Moved = Entries[Index].Service.Get())
+		{
+			Moved->PerceptionSlot = Index;
+		}
+	}
+}
+
+bool FPerceptionScheduler::ConsumeGrant(ULyhBTService* Service)
+{
+	if (!Entries.IsValidIndex(Service->PerceptionSlot))
+	{
+		return true;
+	}
+	FEntry& Entry = Entries[Service->PerceptionSlot];
+	if (Entry.GrantFrame == INDEX_NONE)
+	{
+		return false;
+	}
+	Entry.GrantFrame = INDEX_NONE;
+	Entry.Urgency = 0.f;
+	Outstanding--;
+	return true;
+}
+
+void FPerceptionScheduler::ReportCost(double Seconds)
+{
+	AverageCostMicroseconds = AverageCostMicroseconds * 0.9 + Seconds * 1000000.0 * 0.1;
+}
+
+float FPerceptionScheduler::GetWeight(const FEntry& Entry, const TArray<FVector>& PlayerLocations) const
+{
+	const APawn* Pawn = Entry.Pawn.Get();
+	if (!Pawn)
+	{
+		return 1.f;
+	}
+	float ClosestSquared = FMath::Square(PerceptionScheduler::FarDistance);
+	const FVector Location = Pawn->GetActorLocation();
+	for (const FVector& PlayerLocation : PlayerLocations)
+	{
+		ClosestSquared = FMath::Min(ClosestSquared, FVector::DistSquared(Location, PlayerLocation));
+	}
+	// Up to 4x for monsters next to a player, another 4x while fighting or chasing
+	const float Proximity = 1.f - FMath::Sqrt(ClosestSquared) / PerceptionScheduler::FarDistance;
+	float Weight = 1.f + 3.f * Proximity;
+	const ACombatCharacter* Combatant = Cast<ACombatCharacter>(Pawn);
+	const ULyhBTService* Service = Entry.Service.Get();
+	if ((Combatant && (Combatant->bIsAttacking || Combatant->bIsAttacked)) || (Service && Service->HasEnemy()))
+	{
+		Weight *= 4.f;
+	}
+	return Weight;
+}
+
+void FPerceptionScheduler::Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations)
+{
+	FrameCounter++;
+	Order.Reset();
+	for (int32 Index = Entries.Num() - 1; Index >= 0; --Index)
+	{
+		if (!Entries[Index].Service.IsValid())
+		{
+			RemoveEntry(Index);
+		}
+	}
+	for (int32 Index = 0; Index < Entries.Num(); ++Index)
+	{
+		FEntry& Entry = Entries[Index];
+		// A grant waits for the next tick of its service, however long its interval is. Services that
+		// stop ticking unregister and give their grant back
+		if (Entry.GrantFrame != INDEX_NONE)
+		{
+			continue;
+		}
+		Entry.Urgency += DeltaSeconds * GetWeight(Entry, PlayerLocations);
+		Order.Add(Index);
+	}
+
+	const int32 Affordable = FMath::Max(1, FMath::FloorToInt(BudgetMicroseconds / FMath::Max(AverageCostMicroseconds, 1.0)));
+	const int32 NumGrants = FMath::Min(Affordable - Outstanding, Order.Num());
+	if (NumGrants <= 0)
+	{
+		return;
+	}
+	Order.Sort([this](int32 A, int32 B) { return Entries[A].Urgency > Entries[B].Urgency; });
+	for (int32 Rank = 0; Rank < NumGrants; ++Rank)
+	{
+		Entries[Order[Rank]].GrantFrame = FrameCounter;
+	}
+	Outstanding += NumGrants;
+}
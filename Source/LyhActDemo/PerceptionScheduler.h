@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class APawn;
+class ULyhBTService;
+
+/**
+ * Spreads the enemy checks of all monsters over frames. Every frame each registered monster gains
+ * urgency by its distance to the closest player and its combat state; the most urgent ones are
+ * granted a check until the estimated cost fills the per-frame budget. A grant is kept until the
+ * service uses it on its next tick.
+ */
+class LYHACTDEMO_API FPerceptionScheduler
+{
+public:
+	void SetBudget(float InBudgetMicroseconds) { BudgetMicroseconds = FMath::Max(InBudgetMicroseconds, 1.f); }
+	/** Random is the combat manager's stream, so fixed step runs hand out the same head starts */
+	void Register(ULyhBTService* Service, APawn* Pawn, FRandomStream& Random);
+	void Unregister(ULyhBTService* Service);
+	int32 Num() const { return Entries.Num(); }
+
+	/** True if Service holds a grant it has not used yet, and uses it up. Unregistered services always run */
+	bool ConsumeGrant(ULyhBTService* Service);
+
+	/** Feeds the measured cost of one check into the cost estimate */
+	void ReportCost(double Seconds);
+
+	/** Ages every entry and hands out the grants for the next frame */
+	void Update(float DeltaSeconds, const TArray<FVector>& PlayerLocations);
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<ULyhBTService> Service;
+		TWeakObjectPtr<APawn> Pawn;
+		float Urgency;
+		/** Frame the grant was handed out in, INDEX_NONE when not granted */
+		int32 GrantFrame;
+	};
+
+	void RemoveEntry(int32 Index);
+	float GetWeight(const FEntry& Entry, const TArray<FVector>& PlayerLocations) const;
+
+	TArray<FEntry> Entries;
+	TArray<int32> Order;
+	float BudgetMicroseconds = 500.f;
+	/** Moving average of one check */
+	double AverageCostMicroseconds = 20.0;
+	int32 Outstanding = 0;
+	int32 FrameCounter = 0;
+};
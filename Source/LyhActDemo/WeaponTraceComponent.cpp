@@ -0,0 +1,188 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WeaponTraceComponent.h"
+#include "CombatCharacter.h"
+#include "CombatManager.h"
+#include "CombatProfiling.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/MeshComponent.h"
+#include "GameFramework/Actor.h"
+
+namespace WeaponTrace
+{
+	/** Farthest a capsule surface can be from its actor location, pads the grid query */
+	const float CapsuleMargin = 150.f;
+	/** Most characters one sweep can hit */
+	const int32 MaxCandidates = 32;
+	/** Fewer candidates than this are tested on the game thread, dispatching costs more than it saves */
+	const int32 MinParallelCandidates = 4;
+}
+
+UWeaponTraceComponent::UWeaponTraceComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// Sockets are read after the animation of this frame has been evaluated
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+	BaseSocket = TEXT("BladeBase");
+	TipSocket = TEXT("BladeTip");
+	BladeRadius = 5.f;
+	MaxStepDistance = 20.f;
+	MaxSubSteps = 16;
+	Blade = nullptr;
+}
+
+void UWeaponTraceComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	if (!Blade && GetOwner())
+	{
+		TArray<UMeshComponent*> Meshes;
+		GetOwner()->GetComponents(Meshes);
+		for (UMeshComponent* Mesh : Meshes)
+		{
+			if (Mesh->DoesSocketExist(TipSocket))
+			{
+				SetBlade(Mesh);
+				break;
+			}
+		}
+	}
+}
+
+void UWeaponTraceComponent::SetBlade(UMeshComponent* InBlade)
+{
+	if (Blade)
+	{
+		PrimaryComponentTick.RemovePrerequisite(Blade, Blade->PrimaryComponentTick);
+	}
+	Blade = InBlade;
+	bHasLastSample = false;
+	if (Blade)
+	{
+		PrimaryComponentTick.AddPrerequisite(Blade, Blade->PrimaryComponentTick);
+	}
+}
+
+ACombatCharacter* UWeaponTraceComponent::GetWielder() const
+{
+	AActor* Owner = GetOwner();
+	if (ACombatCharacter* Character = Cast<ACombatCharacter>(Owner))
+	{
+		return Character;
+	}
+	return Owner ? Cast<ACombatCharacter>(Owner->GetAttachParentActor()) : nullptr;
+}
+
+void UWeaponTraceComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	// Hits are only applied on the server, clients do not need to look for them
+	ACombatCharacter* Wielder = GetWielder();
+	if (!Wielder || !Blade || !Wielder->bCanDamage || Wielder->Role != ROLE_Authority)
+	{
+		bHasLastSample = false;
+		return;
+	}
+	if (Wielder->SwingId != LastSwingId)
+	{
+		LastSwingId = Wielder->SwingId;
+		SwingVictims.Reset();
+		bHasLastSample = false;
+	}
+
+	const FVector Base = Blade->GetSocketLocation(BaseSocket);
+	const FVector Tip = Blade->GetSocketLocation(TipSocket);
+	if (!bHasLastSample)
+	{
+		// First frame of the swing only tests where the blade is now
+		LastBase = Base;
+		LastTip = Tip;
+		bHasLastSample = true;
+	}
+	Sweep(Wielder, Base, Tip);
+	LastBase = Base;
+	LastTip = Tip;
+}
+
+void UWeaponTraceComponent::Sweep(ACombatCharacter* Wielder, const FVector& Base, const FVector& Tip)
+{
+	COMBAT_COUNTER_SCOPE(WeaponTrace);
+	ACombatManager* Manager = ACombatManager::Get(this);
+	if (!Manager)
+	{
+		return;
+	}
+
+	// Everything the swept blade can reach this frame
+	FCombatTargetQuery Query;
+	Query.Origin = (LastBase + LastTip + Base + Tip) * 0.25f;
+	Query.Radius = FMath::Sqrt(FMath::Max(
+		FMath::Max(FVector::DistSquared(Query.Origin, LastBase), FVector::DistSquared(Query.Origin, LastTip)),
+		FMath::Max(FVector::DistSquared(Query.Origin, Base), FVector::DistSquared(Query.Origin, Tip))))
+		+ BladeRadius + WeaponTrace::CapsuleMargin;
+	Query.MaxCount = WeaponTrace::MaxCandidates;
+	Query.IgnoreActor = Wielder;
+	TArray<FCombatTarget> Targets;
+	if (Manager->GetTargetGrid().Query(Query, Targets) == 0)
+	{
+		return;
+	}
+
+	Candidates.Reset();
+	for (const FCombatTarget& Target : Targets)
+	{
+		const UCapsuleComponent* Capsule = Target.Character->GetCapsuleComponent();
+		if (Target.Character->bIsDeath || !Capsule || SwingVictims.Contains(Target.Character))
+		{
+			continue;
+		}
+		const FVector Center = Capsule->GetComponentLocation();
+		const FVector Axis = Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere();
+		FCandidate Candidate;
+		Candidate.Character = Target.Character;
+		Candidate.Bottom = Center - Axis;
+		Candidate.Top = Center + Axis;
+		Candidate.Radius = Capsule->GetScaledCapsuleRadius() + BladeRadius;
+		Candidate.Step = INDEX_NONE;
+		Candidates.Add(Candidate);
+	}
+	if (Candidates.Num() == 0)
+	{
+		return;
+	}
+
+	// Enough sub-steps that the tip never jumps further than MaxStepDistance
+	const float TipTravel = FMath::Max(FVector::Dist(LastTip, Tip), FVector::Dist(LastBase, Base));
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt(TipTravel / FMath::Max(MaxStepDistance, 1.f)), 1, FMath::Max(MaxSubSteps, 1));
+	const FVector FromBase = LastBase;
+	const FVector FromTip = LastTip;
+	ParallelFor(Candidates.Num(), [this, NumSteps, &FromBase, &FromTip, &Base, &Tip](int32 Index)
+	{
+		FCandidate& Candidate = Candidates[Index];
+		for (int32 Step = 1; Step <= NumSteps; ++Step)
+		{
+			const float Alpha = (float)Step / NumSteps;
+			FVector OnBlade;
+			FVector OnAxis;
+			FMath::SegmentDistToSegmentSafe(FMath::Lerp(FromBase, Base, Alpha), FMath::Lerp(FromTip, Tip, Alpha), Candidate.Bottom, Candidate.Top, OnBlade, OnAxis);
+			if (FVector::DistSquared(OnBlade, OnAxis) <= FMath::Square(Candidate.Radius))
+			{
+				Candidate.ImpactPoint = OnBlade;
+				Candidate.Step = Step;
+				return;
+			}
+		}
+	}, Candidates.Num() < WeaponTrace::MinParallelCandidates);
+
+	// Report in the order the blade went through them
+	Candidates.Sort([](const FCandidate& A, const FCandidate& B) { return A.Step < B.Step; });
+	for (const FCandidate& Candidate : Candidates)
+	{
+		if (Candidate.Step != INDEX_NONE)
+		{
+			SwingVictims.Add(Candidate.Character);
+			Candidate.Character->OnAttackedBy(Candidate.ImpactPoint, Wielder);
+		}
+	}
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WeaponTraceComponent.generated.h"
+
+class ACombatCharacter;
+class UMeshComponent;
+
+/**
+ * Sword hit detection. While the wielder can damage, the blade between BaseSocket and TipSocket is
+ * sampled every frame and the sweep from last frame's blade to this frame's is cut into sub-steps.
+ * Every candidate from the target grid is tested against the whole sweep in parallel; the first
+ * sub-step touching a capsule gives the impact point passed to OnAttackedBy, once per swing.
+ *
+ * Add it to the character, or to a weapon actor attached to it.
+ */
+UCLASS(ClassGroup = (Combat), meta = (BlueprintSpawnableComponent))
+class LYHACTDEMO_API UWeaponTraceComponent : public UActorComponent
+{
+	GENERATED_BODY()
+public:
+	UWeaponTraceComponent();
+
+	/** Socket at the hilt end of the blade */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+	FName BaseSocket;
+
+	/** Socket at the point of the blade */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+	FName TipSocket;
+
+	/** Thickness added around the blade segment */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+	float BladeRadius;
+
+	/** The tip moves at most this far between two sub-steps, smaller catches more at low frame rates */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+	float MaxStepDistance;
+
+	/** Upper bound of sub-steps per frame */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon")
+	int32 MaxSubSteps;
+
+	/** Component carrying the sockets; found on the owner by TipSocket when not set */
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	void SetBlade(UMeshComponent* InBlade);
+
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+protected:
+	virtual void BeginPlay() override;
+private:
+	/** Character the hits are reported for */
+	ACombatCharacter* GetWielder() const;
+	void Sweep(ACombatCharacter* Wielder, const FVector& Base, const FVector& Tip);
+
+	/** Capsule of a candidate, copied out on the game thread before the parallel test */
+	struct FCandidate
+	{
+		ACombatCharacter* Character;
+		FVector Bottom;
+		FVector Top;
+		float Radius;
+		/** First impact, valid when Step is not INDEX_NONE */
+		FVector ImpactPoint;
+		int32 Step;
+	};
+
+	UPROPERTY()
+	UMeshComponent* Blade;
+
+	bool bHasLastSample = false;
+	FVector LastBase;
+	FVector LastTip;
+	uint32 LastSwingId = 0;
+	/** Already hit during the current swing */
+	TArray<TWeakObjectPtr<ACombatCharacter>> SwingVictims;
+	TArray<FCandidate> Candidates;
+};